@@ -1,4 +1,5 @@
 #include "big_integer.h"
+#include "limbs.h"
 #include <iostream>
 #include <algorithm>
 #include <cmath>
@@ -15,7 +16,7 @@ big_integer::big_integer()
 }
 
 ui cast(int x) {
-    return static_cast<ui>(abs(x));
+    return x < 0 ? 0 - static_cast<ui>(x) : static_cast<ui>(x);
 }
 
 template<typename T>
@@ -32,12 +33,14 @@ big_integer::big_integer(ui a) {
     data_[0] = a;
 }
 
-big_integer::big_integer(std::string const &str) {
+big_integer::big_integer(std::string const &str) : big_integer(str, 10) {
+}
+
+big_integer::big_integer(std::string const &str, int base) {
+    if (base < 2 || base > 36)
+        throw "BASE";
     bool sign = str[0] == '-';
-    for (size_t i = cast(sign); i < str.length(); i++) {
-        *this *= 10;
-        *this += str[i] - '0';
-    }
+    *this = parse(str.data() + cast(sign), str.length() - cast(sign), static_cast<unsigned>(base));
     if (*this != 0)
         sign_ = sign;
 }
@@ -56,24 +59,18 @@ big_integer &big_integer::operator=(big_integer const &other) {
 
 big_integer &big_integer::abs_add(big_integer const &rhs, bool sign) {
     sign_ = sign;
-    size_t m = std::max(size_, rhs.size_);
-    if (m >= size_ + 1) {
-        *this = resize(m + 1);
-    }
-    ull sum = 0;
-    bool carry = 0;
-    for (size_t i = 0; i < m; i++) {
-        sum = (ull) data_[i] + (rhs.size_ > i ? rhs.data_[i] : 0) + carry;
-        carry = (sum >> SHIFT) > 0;
-        data_[i] = cast(sum & UMAX);
-    }
+    size_t n = std::max(size_, rhs.size_);
+    grow(n + 1);
 
-    size_ = m;
-    if (carry != 0) {
-        data_[m] = cast(carry);
-        size_++;
-    }
+    ui *d = data_.data();
+    ui const *b = rhs.data_.data();
+    if (size_ >= rhs.size_)
+        d[n] = limbs::add(d, d, size_, b, rhs.size_);
+    else
+        d[n] = limbs::add(d, b, rhs.size_, d, size_);
 
+    size_ = n + 1;
+    normalize(*this);
     return *this;
 }
 
@@ -84,16 +81,8 @@ big_integer &big_integer::abs_sub(big_integer const &rhs, bool sign, int comp) {
         return abs_sub(temp, sign, 1);
     }
 
-    ull buf = 0;
-    bool carry = 0;
-    for (size_t i = 0; i < size_; i++) {
-        buf = SHIFTED + data_[i];
-        buf -= (rhs.size_ > i ? rhs.data_[i] : 0) + carry;
-        if (buf >> SHIFT == 0)
-            carry = 1;
-        else carry = 0;
-        data_[i] = cast(buf & UMAX);
-    }
+    ui *d = data_.data();
+    limbs::sub(d, d, size_, rhs.data_.data(), rhs.size_);
 
     normalize(*this);
     sign_ = sign;
@@ -133,6 +122,131 @@ big_integer &big_integer::resize(size_t size) {
     return *this;
 }
 
+// makes room for size limbs, the ones above size_ are zero
+void big_integer::grow(size_t size) {
+    if (data_.size() < size)
+        data_.resize(size, 0);
+    for (size_t i = size_; i < size; i++)
+        data_[i] = 0;
+}
+
+big_integer big_integer::from_small(ull mag, bool neg) {
+    big_integer r(cast(mag & UMAX));
+    if (mag >> SHIFT) {
+        r.data_.push_back(cast(mag >> SHIFT));
+        r.size_ = 2;
+    }
+    r.sign_ = neg && mag != 0;
+    return r;
+}
+
+int big_integer::compare_small(big_integer const &a, ull mag, bool neg) {
+    neg = neg && mag != 0;
+    if (a.sign_ != neg)
+        return a.sign_ ? -1 : 1;
+
+    int comp = 1;
+    if (a.size_ <= 2) {
+        ull value = a.data_[0] + (a.size_ == 2 ? (ull) a.data_[1] << SHIFT : 0);
+        comp = value < mag ? -1 : value > mag;
+    }
+    return a.sign_ ? -comp : comp;
+}
+
+big_integer &big_integer::add_small(ull mag, bool neg) {
+    if (size_ == 1 && data_[0] == 0)
+        sign_ = neg;
+
+    ui b[2] = {cast(mag & UMAX), cast(mag >> SHIFT)};
+    size_t bn = b[1] ? 2 : 1;
+    if (sign_ == neg) {
+        size_t n = std::max(size_, bn);
+        grow(n + 1);
+        ui *d = data_.data();
+        d[n] = limbs::add(d, d, n, b, bn);
+        size_ = n + 1;
+    } else if (compare_small(*this, mag, sign_) * (sign_ ? -1 : 1) >= 0) {
+        ui *d = data_.data();
+        limbs::sub(d, d, size_, b, bn);
+    } else {
+        // |this| < mag, so both fit in a machine word
+        ull value = data_[0] + (size_ == 2 ? (ull) data_[1] << SHIFT : 0);
+        big_integer r = from_small(mag - value, neg);
+        swap(*this, r);
+    }
+
+    normalize(*this);
+    return *this;
+}
+
+big_integer &big_integer::mul_small(ull mag, bool neg) {
+    sign_ ^= neg;
+    if (mag <= UMAX) {
+        grow(size_ + 1);
+        ui *d = data_.data();
+        d[size_] = limbs::mul_1(d, d, size_, cast(mag));
+        size_++;
+    } else {
+        ui b[2] = {cast(mag & UMAX), cast(mag >> SHIFT)};
+        my_vector temp(size_ + 2);
+        limbs::mul_basecase(temp.data(), data_.data(), size_, b, 2);
+        data_.swap(temp);
+        size_ += 2;
+    }
+
+    normalize(*this);
+    return *this;
+}
+
+static size_t low_bit(ull mag) {
+    size_t k = 0;
+    for (; !(mag & 1); mag >>= 1)
+        k++;
+    return k;
+}
+
+big_integer &big_integer::div_small(ull mag, bool neg) {
+    if (mag == 0)
+        throw "DBZ";
+    if ((mag & (mag - 1)) == 0) {
+        abs_shr(low_bit(mag));
+        sign_ ^= neg;
+        normalize(*this);
+        return *this;
+    }
+    if (mag > UMAX)
+        return *this /= from_small(mag, neg);
+
+    ui *d = data_.data();
+    limbs::divrem_1(d, d, size_, cast(mag));
+    sign_ ^= neg;
+    normalize(*this);
+    return *this;
+}
+
+ui big_integer::divrem_small(ui d) {
+    if (d == 0)
+        throw "DBZ";
+    ui *p = data_.data();
+    ui r = limbs::divrem_1(p, p, size_, d);
+    normalize(*this);
+    return r;
+}
+
+big_integer &big_integer::mod_small(ull mag, bool neg) {
+    if (mag == 0)
+        throw "DBZ";
+    if ((mag & (mag - 1)) == 0)
+        return *this = mod_2exp(*this, low_bit(mag));
+    if (mag > UMAX)
+        return *this %= from_small(mag, neg);
+
+    big_integer r(limbs::mod_1(data_.data(), size_, cast(mag)));
+    r.sign_ = sign_ && r.data_[0] != 0;
+    swap(*this, r);
+    return *this;
+}
+
 
 big_integer &big_integer::operator-=(big_integer const &rhs) {
     if (sign_ && !rhs.sign_)
@@ -155,44 +269,132 @@ big_integer &big_integer::operator-=(big_integer const &rhs) {
     }
 }
 
-void big_integer::add_big_int(my_vector &a, ui x, size_t index) {
-    ull sum = x;
-    bool carry = 0;
-    while (true) {
-        sum += a[index] + carry;
-        carry = (sum >> SHIFT) > 0;
-        a[index] = cast(sum & UMAX);
-        sum = 0;
-        index++;
-        if (carry == 0)
-            break;
-    }
-}
-
 big_integer &big_integer::operator*=(big_integer const &rhs) {
     my_vector temp(size_ + rhs.size_);
-
-    ull prod;
-    for (size_t i = 0; i < size_; i++) {
-        for (size_t j = 0; j < rhs.size_; j++) {
-            prod = (ull) data_[i] * rhs.data_[j];
-            ui lower = cast(prod & UMAX);
-            ui higher = cast(prod >> SHIFT);
-
-            add_big_int(temp, lower, i + j);
-            add_big_int(temp, higher, i + j + 1);
-        }
-    }
+    ui const *a = data_.data();
+    ui const *b = rhs.data_.data();
+    if (a != b && abs_compare(*this, rhs) == 0)
+        b = a; // x * x: the limbs are equal, let the kernels square
+    limbs::mul(temp.data(), a, size_, b, rhs.size_);
 
     sign_ ^= rhs.sign_;
     size_ += rhs.size_;
 
-    this->data_ = temp;
+    data_.swap(temp);
     normalize(*this);
 
     return *this;
 }
 
+big_integer &big_integer::addmul(big_integer const &a, big_integer const &b) {
+    if (&a == this || &b == this)
+        return *this += a * b;
+    return add_product(a, b.data_.data(), b.size_, a.sign_ ^ b.sign_);
+}
+
+big_integer &big_integer::submul(big_integer const &a, big_integer const &b) {
+    if (&a == this || &b == this)
+        return *this -= a * b;
+    return add_product(a, b.data_.data(), b.size_, !(a.sign_ ^ b.sign_));
+}
+
+big_integer big_integer::mul_low(big_integer const &a, big_integer const &b, size_t n) {
+    big_integer r;
+    if (n == 0)
+        return r;
+
+    my_vector temp(n);
+    limbs::mullo(temp.data(), a.data_.data(), a.size_, b.data_.data(), b.size_, n);
+    r.data_.swap(temp);
+    r.size_ = n;
+    r.sign_ = a.sign_ ^ b.sign_;
+    normalize(r);
+    return r;
+}
+
+big_integer big_integer::mul_high(big_integer const &a, big_integer const &b, size_t n) {
+    big_integer r;
+    if (n >= a.size_ + b.size_)
+        return r;
+
+    my_vector temp(a.size_ + b.size_ - n);
+    limbs::mulhi(temp.data(), a.data_.data(), a.size_, b.data_.data(), b.size_, n);
+    r.data_.swap(temp);
+    r.size_ = a.size_ + b.size_ - n;
+    r.sign_ = a.sign_ ^ b.sign_;
+    normalize(r);
+    return r;
+}
+
+big_integer &big_integer::addmul_small(big_integer const &a, ull mag, bool neg) {
+    if (&a == this) {
+        big_integer temp(a);
+        return addmul_small(temp, mag, neg);
+    }
+    ui b[2] = {cast(mag & UMAX), cast(mag >> SHIFT)};
+    return add_product(a, b, b[1] ? 2 : 1, a.sign_ ^ neg);
+}
+
+// *this += a * b, where the product has sign neg; a and b must not live in *this
+big_integer &big_integer::add_product(big_integer const &x, ui const *b, size_t bn, bool neg) {
+    ui const *a = x.data_.data();
+    size_t an = x.size_;
+    if (an < bn) {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+    if ((an == 1 && a[0] == 0) || (bn == 1 && b[0] == 0))
+        return *this;
+    if (size_ == 1 && data_[0] == 0)
+        sign_ = neg;
+
+    size_t pn = an + bn;
+    bool rows = bn < limbs::KARATSUBA_THRESHOLD;
+    if (rows && sign_ == neg) {
+        // one short operand: add its rows straight into our limbs
+        size_t n = std::max(size_, pn) + 1;
+        grow(n);
+        ui *d = data_.data();
+        for (size_t j = 0; j < bn; j++) {
+            ui carry = limbs::addmul_1(d + j, a, an, b[j]);
+            limbs::add_1(d + j + an, d + j + an, n - j - an, carry);
+        }
+        size_ = n;
+    } else if (rows && size_ > pn) {
+        // |this| >= B^pn > |a * b|, so the borrows die inside our limbs
+        ui *d = data_.data();
+        for (size_t j = 0; j < bn; j++) {
+            ui borrow = limbs::submul_1(d + j, a, an, b[j]);
+            limbs::sub_1(d + j + an, d + j + an, size_ - j - an, borrow);
+        }
+    } else {
+        my_vector temp(pn);
+        ui *p = temp.data();
+        limbs::mul(p, a, an, b, bn);
+        while (pn > 1 && p[pn - 1] == 0)
+            pn--;
+
+        if (sign_ == neg) {
+            size_t n = std::max(size_, pn) + 1;
+            grow(n);
+            ui *d = data_.data();
+            d[n - 1] = limbs::add(d, d, n - 1, p, pn);
+            size_ = n;
+        } else if (size_ > pn || (size_ == pn && limbs::cmp(data_.data(), p, pn) >= 0)) {
+            ui *d = data_.data();
+            limbs::sub(d, d, size_, p, pn);
+        } else {
+            limbs::sub(p, p, pn, data_.data(), size_);
+            data_.swap(temp);
+            size_ = pn;
+            sign_ = neg;
+        }
+    }
+
+    normalize(*this);
+    return *this;
+}
+
 void big_integer::normalize(big_integer &a) {
     while (a.size_ > 1 && a.data_[a.size_ - 1] == 0) {
         a.size_--;
@@ -212,62 +414,335 @@ static int max_bit(ui n) {
     return temp;
 }
 
-big_integer &big_integer::operator/=(big_integer const &rhs) {
-    if (rhs == 0)
+size_t big_integer::bit_length(big_integer const &a) {
+    return (a.size_ - 1) * SHIFT + static_cast<size_t>(max_bit(a.data_[a.size_ - 1]) + 1);
+}
+
+static big_integer power_of_two(size_t k) {
+    return big_integer(1) << static_cast<int>(k);
+}
+
+// a - q d for a, q, d >= 0, when the difference is known to be below 2^(32 w - 1) in
+// magnitude: then it is fixed by the low w limbs, and q d has no need of its top ones
+static big_integer low_difference(big_integer const &a, big_integer const &q, big_integer const &d, size_t w) {
+    big_integer base = power_of_two(w * SHIFT);
+    big_integer r = (a & (base - 1)) - big_integer::mul_low(q, d, w);
+    big_integer half = base >> 1;
+    if (r >= half)
+        r -= base;
+    else if (r < -half)
+        r += base;
+    return r;
+}
+
+// floor(2^k / d) for d > 0, give or take a few. Newton's iteration x += x (2^k - d x) / 2^k
+// doubles the correct bits of x, so x is first found to half the precision, from the top
+// bits of d alone.
+big_integer big_integer::recip_approx(big_integer const &d, size_t k) {
+    size_t const guard = 4;
+    size_t m = bit_length(d);
+    if (k + 1 < m)
+        return 0;
+    size_t p = k - m + 1; // bits of the result
+    if (p < SHIFT * NEWTON_RECIP_THRESHOLD)
+        return divmod(power_of_two(k), d).first;
+
+    size_t s = p / 2 - guard;
+    size_t t = m > p - s + guard ? m - (p - s + guard) : 0;
+    big_integer xh = recip_approx(d >> static_cast<int>(t), k - s - t);
+
+    // x = xh 2^s, e = (2^k - d x) / 2^s is a few times d at most, as xh is a few units off.
+    // The correction x e / 2^k only needs the top bits of e
+    big_integer e = low_difference(power_of_two(k - s), xh, d, m / SHIFT + 2);
+    bool neg = e.sign_;
+    e.sign_ = false;
+    size_t u = bit_length(e) > s + 2 * guard ? bit_length(e) - s - 2 * guard : 0;
+    big_integer delta = (xh * (e >> static_cast<int>(u))) >> static_cast<int>(k - u - 2 * s);
+    if (neg)
+        delta = -delta;
+    return (xh << static_cast<int>(s)) + delta;
+}
+
+big_integer big_integer::reciprocal(big_integer const &x, size_t precision) {
+    if (x == 0)
         throw "DBZ";
-    if (abs_compare(*this, rhs) == -1) {
-        return *this = 0;
-    }
-    bool neg = sign_ ^rhs.sign_;
-
-    if (rhs.size_ == 1) {
-        ui carry = 0;
-        ui divisor = rhs.data_[0];
-        for (size_t i = size_ - 1; i + 1 != 0; --i) {
-            ull cur = data_[i] + carry * SHIFTED;
-            data_[i] = cast(cur / divisor);
-            carry = cast(cur % divisor);
-        }
-        normalize(*this);
-        sign_ = neg;
-        return *this;
+    big_integer d(x);
+    d.sign_ = false;
+    big_integer q = recip_approx(d, precision);
+    big_integer r = low_difference(power_of_two(precision), q, d, d.size_ + 1);
+    while (r < 0) {
+        --q;
+        r += d;
     }
+    while (r >= d) {
+        ++q;
+        r -= d;
+    }
+    q.sign_ = x.sign_;
+    normalize(q);
+    return q;
+}
 
-    ui shift = SHIFT - 1 - max_bit(rhs.data_[rhs.size_ - 1]);
-    big_integer b = rhs << shift;
-    sign_ = false;
-    b.sign_ = false;
-    *this <<= shift;;
+big_integer big_integer::adopt(my_vector &v, size_t n, bool neg) {
+    big_integer r;
+    r.data_.swap(v);
+    r.size_ = n;
+    r.sign_ = neg;
+    normalize(r);
+    return r;
+}
+
+// a / d for d shifted left by shift to have the top bit set, dinv = limbs::invert_limb(d)
+std::pair<big_integer, big_integer> big_integer::divmod_1(big_integer const &a, ui d, unsigned shift, ui dinv,
+                                                          bool neg) {
+    big_integer q(a);
+    ui *qp = q.data_.data();
+    big_integer r(limbs::divrem_1(qp, qp, q.size_, d, shift, dinv));
+    q.sign_ = neg;
+    normalize(q);
+    r.sign_ = a.sign_ && r.data_[0] != 0;
+    return {q, r};
+}
+
+// a / d for the m limbs of d shifted left by shift to have the top bit set
+std::pair<big_integer, big_integer> big_integer::divmod_knuth(big_integer const &a, ui const *d, size_t m,
+                                                              unsigned shift, ui dinv, bool neg) {
+    size_t n = a.size_;
+    my_vector rv(n + 1), qv(n - m + 2);
+    ui *rp = rv.data();
+    if (shift) {
+        rp[n] = limbs::lshift(rp, a.data_.data(), n, shift);
+    } else {
+        std::copy(a.data_.data(), a.data_.data() + n, rp);
+        rp[n] = 0;
+    }
 
-    size_t n = size_;
+    ui *qp = qv.data();
+    qp[n - m + 1] = limbs::div_qr(qp, rp, n + 1, d, m, dinv);
+    if (shift)
+        limbs::rshift(rp, rp, m, shift);
+
+    my_vector rem(m);
+    std::copy(rp, rp + m, rem.data());
+    return {adopt(qv, n - m + 2, neg), adopt(rem, m, a.sign_)};
+}
+
+std::pair<big_integer, big_integer> big_integer::divmod(big_integer const &a, big_integer const &b) {
+    if (b == 0)
+        throw "DBZ";
+    if (abs_compare(a, b) == -1)
+        return {big_integer(), a};
+    bool neg = a.sign_ ^ b.sign_;
+    size_t n = a.size_;
     size_t m = b.size_;
 
-    big_integer q;
-    q.resize(n - m + 1);
-    q.size_ = n - m + 1;
-    ull d1 = b.data_[m - 1];
-    if (data_.capacity() == size_)
-        resize(size_ + 1);
-    for (size_t k = n - m + 1; k && *this >= b; --k) {
-        size_t km = k + m;
-        ull r2 = (data_[km - 1] * SHIFTED) + data_[km - 2];
-        ui trial = (ui) std::min(static_cast<ull>(r2 / d1), SHIFTED - 1);
-
-        *this -= (b * trial) << (SHIFT * (k - 1));
-        q.data_[k - 1] = cast(trial);
-        while (*this < 0) {
-            *this += b << (SHIFT * (k - 1));
-            q.data_[k - 1]--;
+    // a power of two divides by a shift; zero limbs at the bottom of b only pass the ones
+    // of a on to the remainder
+    size_t z = trailing_zeros(b);
+    if (z + 1 == bit_length(b)) {
+        big_integer q = tdiv_q_2exp(a, z);
+        q.sign_ = neg;
+        normalize(q);
+        return {q, mod_2exp(a, z)};
+    }
+    if (z >= SHIFT) {
+        size_t low = z / SHIFT;
+        my_vector xv(n - low), yv(m - low);
+        std::copy(a.data_.data() + low, a.data_.data() + n, xv.data());
+        std::copy(b.data_.data() + low, b.data_.data() + m, yv.data());
+        std::pair<big_integer, big_integer> qr = divmod(adopt(xv, n - low, a.sign_), adopt(yv, m - low, b.sign_));
+        big_integer const &r = qr.second;
+        my_vector rv(low + r.size_);
+        std::copy(a.data_.data(), a.data_.data() + low, rv.data());
+        std::copy(r.data_.data(), r.data_.data() + r.size_, rv.data() + low);
+        return {qr.first, adopt(rv, low + r.size_, a.sign_)};
+    }
+
+    // the divisor is shifted to have its top bit set, the dividend along with it
+    unsigned shift = SHIFT - 1 - max_bit(b.data_[m - 1]);
+    if (m == 1) {
+        ui d = b.data_[0] << shift;
+        return divmod_1(a, d, shift, limbs::invert_limb(d), neg);
+    }
+
+    my_vector dv(m);
+    ui *d = dv.data();
+    if (shift)
+        limbs::lshift(d, b.data_.data(), m, shift);
+    else
+        std::copy(b.data_.data(), b.data_.data() + m, d);
+    return divmod_knuth(a, d, m, shift, limbs::invert_3by2(d[m - 1], d[m - 2]), neg);
+}
+
+big_integer big_integer::tdiv_q_2exp(big_integer const &a, size_t k) {
+    big_integer q(a);
+    q.abs_shr(k);
+    return q;
+}
+
+big_integer big_integer::fdiv_q_2exp(big_integer const &a, size_t k) {
+    big_integer q(a);
+    q.abs_shr(k);
+    if (a.sign_ && trailing_zeros(a) < k)
+        q -= 1;
+    return q;
+}
+
+big_integer big_integer::mod_2exp(big_integer const &a, size_t k) {
+    size_t n = std::min(a.size_, (k + SHIFT - 1) / SHIFT);
+    if (n == 0)
+        return big_integer();
+    my_vector v(n);
+    std::copy(a.data_.data(), a.data_.data() + n, v.data());
+    if (n * SHIFT > k)
+        v[n - 1] &= (1u << (k % SHIFT)) - 1;
+    return adopt(v, n, a.sign_);
+}
+
+bool big_integer::divisible_by(big_integer const &d) const {
+    if (*this == 0)
+        return true;
+    if (d == 0)
+        return false;
+    return limbs::divisible(data_.data(), size_, d.data_.data(), d.size_);
+}
+
+bool big_integer::divisible_small(ull mag) const {
+    if (mag > UMAX)
+        return divisible_by(from_small(mag, false));
+    ui d = cast(mag);
+    return *this == 0 || (d != 0 && limbs::divisible(data_.data(), size_, &d, 1));
+}
+
+big_integer big_integer::divexact(big_integer const &a, big_integer const &b) {
+    if (b == 0)
+        throw "DBZ";
+    if (abs_compare(a, b) == -1)
+        return big_integer();
+    size_t qn = a.size_ - b.size_ + 1;
+    if (std::min(qn, b.size_) >= DIVEXACT_DIV_THRESHOLD && b.size_ < 2 * qn)
+        return divmod(a, b).first;
+    my_vector qv(qn);
+    limbs::divexact(qv.data(), a.data_.data(), a.size_, b.data_.data(), b.size_);
+    return adopt(qv, qn, a.sign_ ^ b.sign_);
+}
+
+// Barrett's reduction, a chunk of m limbs of |a| at a time from the top: with the remainder
+// so far in front, a chunk t is below d B^m, and the top m + 1 limbs of t times
+// floor(B^(2m) / d) give t / d up to two units
+std::pair<big_integer, big_integer> big_integer::divmod_barrett(big_integer const &a, big_divisor const &b) {
+    big_integer d(b.value_);
+    d.sign_ = false;
+    size_t n = a.size_;
+    size_t m = d.size_;
+    my_vector qv(n, 0);
+    big_integer r;
+    for (size_t off = n - ((n - 1) % m + 1);; off -= m) {
+        size_t len = std::min(m, n - off);
+        my_vector tv(len + r.size_);
+        std::copy(a.data_.data() + off, a.data_.data() + off + len, tv.data());
+        std::copy(r.data_.data(), r.data_.data() + r.size_, tv.data() + len);
+        big_integer t = adopt(tv, len + r.size_, false);
+
+        big_integer q = mul_high(t >> static_cast<int>(SHIFT * (m - 1)), b.barrett_, m + 1);
+        r = low_difference(t, q, d, m + 1);
+        while (r >= d) {
+            r -= d;
+            ++q;
         }
+        std::copy(q.data_.data(), q.data_.data() + q.size_, qv.data() + off);
+        if (off == 0)
+            break;
     }
-    q.sign_ = neg;
-    normalize(q);
-    swap(*this, q);
+    r.sign_ = a.sign_;
+    normalize(r);
+    return {adopt(qv, n, a.sign_ ^ b.value_.sign_), r};
+}
+
+std::pair<big_integer, big_integer> big_integer::divmod(big_integer const &a, big_divisor const &b) {
+    if (abs_compare(a, b.value_) == -1)
+        return {big_integer(), a};
+    bool neg = a.sign_ ^ b.value_.sign_;
+    size_t m = b.value_.size_;
+    if (m == 1)
+        return divmod_1(a, b.norm_[0], b.shift_, b.dinv_, neg);
+    if (b.barrett_ != 0)
+        return divmod_barrett(a, b);
+    return divmod_knuth(a, b.norm_.data(), m, b.shift_, b.dinv_, neg);
+}
+
+big_divisor::big_divisor(big_integer const &d)
+        : value_(d), norm_(d.size_), shift_(0), dinv_(0) {
+    if (d == 0)
+        throw "DBZ";
+    size_t m = d.size_;
+    ui const *p = d.data_.data();
+    shift_ = SHIFT - 1 - max_bit(p[m - 1]);
+    if (shift_)
+        limbs::lshift(norm_.data(), p, m, shift_);
+    else
+        std::copy(p, p + m, norm_.data());
+    dinv_ = m == 1 ? limbs::invert_limb(norm_[0]) : limbs::invert_3by2(norm_[m - 1], norm_[m - 2]);
+    if (m >= BARRETT_DIV_THRESHOLD)
+        barrett_ = big_integer::reciprocal(d >= 0 ? d : -d, 2 * SHIFT * m);
+}
+
+big_integer &big_integer::operator/=(big_integer const &rhs) {
+    std::pair<big_integer, big_integer> qr = divmod(*this, rhs);
+    swap(*this, qr.first);
     return *this;
 }
 
 big_integer &big_integer::operator%=(big_integer const &rhs) {
-    return *this = *this - (*this / rhs) * rhs;
+    std::pair<big_integer, big_integer> qr = divmod(*this, rhs);
+    swap(*this, qr.second);
+    return *this;
+}
+
+// the truncated quotient one further from zero and the remainder that goes with it: |q| + 1,
+// and |b| - |r| with the opposite sign
+void big_integer::round_away(std::pair<big_integer, big_integer> &qr, big_integer const &b, bool neg) {
+    qr.first.add_small(1, neg);
+    big_integer &r = qr.second;
+    size_t m = b.size_;
+    r.grow(m);
+    limbs::sub(r.data_.data(), b.data_.data(), m, r.data_.data(), r.size_);
+    r.size_ = m;
+    r.sign_ = !r.sign_;
+    normalize(r);
+}
+
+std::pair<big_integer, big_integer> big_integer::fdiv_qr(big_integer const &a, big_integer const &b) {
+    std::pair<big_integer, big_integer> qr = divmod(a, b);
+    if (qr.second != 0 && a.sign_ != b.sign_)
+        round_away(qr, b, true);
+    return qr;
+}
+
+std::pair<big_integer, big_integer> big_integer::cdiv_qr(big_integer const &a, big_integer const &b) {
+    std::pair<big_integer, big_integer> qr = divmod(a, b);
+    if (qr.second != 0 && a.sign_ == b.sign_)
+        round_away(qr, b, false);
+    return qr;
+}
+
+std::pair<big_integer, big_integer> big_integer::ediv_qr(big_integer const &a, big_integer const &b) {
+    std::pair<big_integer, big_integer> qr = divmod(a, b);
+    if (qr.second != 0 && a.sign_)
+        round_away(qr, b, !b.sign_);
+    return qr;
+}
+
+big_integer &big_integer::operator/=(big_divisor const &rhs) {
+    std::pair<big_integer, big_integer> qr = divmod(*this, rhs);
+    swap(*this, qr.first);
+    return *this;
+}
+
+big_integer &big_integer::operator%=(big_divisor const &rhs) {
+    std::pair<big_integer, big_integer> qr = divmod(*this, rhs);
+    swap(*this, qr.second);
+    return *this;
 }
 
 big_integer &big_integer::operator&=(big_integer const &rhs) {
@@ -283,48 +758,44 @@ big_integer &big_integer::operator^=(big_integer const &rhs) {
     return apply_bitwise_operation(rhs, std::bit_xor<uint32_t>());
 }
 
-big_integer big_integer::inverse(big_integer a) {
-    if (a.sign_ == 0) {
-        return a;
+static void negate(ui *d, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        d[i] = ~d[i];
     }
+    limbs::add_1(d, d, n, 1);
+}
 
-    for (size_t i = 0; i < a.data_.size(); i++) {
-        a.data_[i] = ~a.data_[i];
+// a in two's complement, n limbs wide
+my_vector big_integer::inverse(big_integer const &a, size_t n) {
+    my_vector r(n, 0);
+    std::copy(a.data_.data(), a.data_.data() + a.size_, r.data());
+    if (a.sign_) {
+        negate(r.data(), n);
     }
-    return a;
+    return r;
 }
 
 template<class FunctorT>
 big_integer &big_integer::apply_bitwise_operation(big_integer const &rhs, FunctorT functor) {
-    big_integer that = inverse(rhs);
-    *this = inverse(*this);
-
-    if (sign_) {
-        --*this;
-    }
-    if (that.sign_) {
-        --that;
-    }
-
-    if (data_.size() > that.data_.size()) {
-        swap(*this, that);
-    }
-
-    for (size_t i = 0; i < that.data_.size(); i++) {
-        if (i >= data_.size()) {
-            data_.push_back(sign_ == 1 ? UMAX : 0);
-        }
-        data_[i] = functor(data_[i], that.data_[i]);
-        sign_ = functor(sign_, that.sign_);
+    size_t n = std::max(size_, rhs.size_) + 1;
+    my_vector a = inverse(*this, n);
+    my_vector b = inverse(rhs, n);
+
+    ui *d = a.data();
+    ui const *e = b.data();
+    for (size_t i = 0; i < n; i++) {
+        d[i] = functor(d[i], e[i]);
     }
 
+    sign_ = d[n - 1] >> (SHIFT - 1);
     if (sign_) {
-        data_.push_back(UMAX);
-        *this = inverse(*this + 1);
+        negate(d, n);
     }
 
+    data_.swap(a);
+    size_ = n;
     normalize(*this);
-    return *this ;
+    return *this;
 }
 
 big_integer &big_integer::operator<<=(int rhs) {
@@ -332,69 +803,64 @@ big_integer &big_integer::operator<<=(int rhs) {
         return *this >>= -rhs;
     }
 
-    ui shift = cast(rhs / SHIFT);
-    rhs %= SHIFT;
-
-    if (data_.size() <= size_ + shift)
-        resize(size_ + shift + 1);
-
-    ull num;
-    ull last = (SHIFTED * data_[size_] + data_[size_ - 1]) << rhs;
+    size_t shift = static_cast<size_t>(rhs) / SHIFT;
+    unsigned bits = static_cast<unsigned>(rhs) % SHIFT;
 
-    for (size_t i = size_ - 1; --i + 1;) {
-        num = SHIFTED * data_[i + 1] + data_[i];
-        num <<= rhs;
-
-        data_[i + shift + 2] = cast((last >> SHIFT) & UMAX);
-        last = num;
-    }
-    data_[shift + 1] = cast((last >> SHIFT) & UMAX);
-    data_[shift] = cast(last & UMAX);
-
-    for (size_t i = shift; --i + 1;)
-        data_[i] = 0;
+    my_vector temp(size_ + shift + 1, 0);
+    ui *d = temp.data();
+    ui const *a = data_.data();
+    if (bits)
+        d[size_ + shift] = limbs::lshift(d + shift, a, size_, bits);
+    else
+        std::copy(a, a + size_, d + shift);
 
+    data_.swap(temp);
     size_ += shift + 1;
     normalize(*this);
     return *this;
 }
 
-big_integer &big_integer::operator>>=(int rhs) {
-    if (rhs < 0) {
-        return *this <<= -rhs;
+// |*this| >> k, the sign is kept
+void big_integer::abs_shr(size_t k) {
+    size_t shift = k / SHIFT;
+    unsigned bits = static_cast<unsigned>(k % SHIFT);
+    if (shift >= size_) {
+        clear(*this, 1);
+        return;
     }
+    ui *d = data_.data();
+    size_t n = size_ - shift;
+    if (bits)
+        limbs::rshift(d, d + shift, n, bits);
+    else
+        std::copy(d + shift, d + size_, d);
+    std::fill(d + n, d + data_.size(), 0);
+    size_ = n;
+    normalize(*this);
+}
 
-    bool neg = false;
-    if (sign_) {
-        neg = true;
-        *this = ~*this;
-    }
-
-    if (size_ == 1) {
-        data_[0] >>= rhs;
-    } else {
-        ui shift = cast(rhs / SHIFT);
-        rhs %= SHIFT;
-        ull num;
-        ull last = (SHIFTED * data_[1] + data_[0]) >> rhs;
-
-        for (size_t i = 1 + shift; i < size_ - 1; i++) {
-            num = SHIFTED * data_[i + 1] + data_[i];
-            num >>= rhs;
-
-            data_[i - shift - 1] = cast(last & UMAX);
-            last = num;
-        }
-        data_[size_ - 1 - shift] = cast((last >> SHIFT) & UMAX);
-        data_[size_ - 2 - shift] = cast(last & UMAX);
+size_t big_integer::trailing_zeros(big_integer const &a) {
+    size_t i = 0;
+    while (i < a.size_ && a.data_[i] == 0)
+        i++;
+    if (i == a.size_)
+        return 0;
+    size_t k = i * SHIFT;
+    for (ui x = a.data_[i]; !(x & 1); x >>= 1)
+        k++;
+    return k;
+}
 
-        size_ -= shift;
+big_integer &big_integer::operator>>=(int rhs) {
+    if (rhs < 0) {
+        return *this <<= -rhs;
     }
 
-    if (neg)
-        *this = ~*this;
-
-    normalize(*this);
+    // negative numbers round toward minus infinity: one more when a set bit is shifted out
+    bool down = sign_ && trailing_zeros(*this) < static_cast<size_t>(rhs);
+    abs_shr(static_cast<size_t>(rhs));
+    if (down)
+        *this -= 1;
     return *this;
 }
 
@@ -457,6 +923,14 @@ big_integer operator%(big_integer a, big_integer const &b) {
     return a %= b;
 }
 
+big_integer operator/(big_integer a, big_divisor const &b) {
+    return a /= b;
+}
+
+big_integer operator%(big_integer a, big_divisor const &b) {
+    return a %= b;
+}
+
 big_integer operator&(big_integer a, big_integer const &b) {
     return a &= b;
 }
@@ -524,30 +998,325 @@ bool operator>=(big_integer const &a, big_integer const &b) {
     return !(a < b);
 }
 
-std::string to_string(big_integer const &a) {
-    if (a == 0) {
-        return "0";
+static char const DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// the value of a digit character in any base up to 36, or 36 if c is not one
+static ui digit_value(char c) {
+    if (c >= '0' && c <= '9')
+        return static_cast<ui>(c - '0');
+    if (c >= 'a' && c <= 'z')
+        return static_cast<ui>(c - 'a' + 10);
+    if (c >= 'A' && c <= 'Z')
+        return static_cast<ui>(c - 'A' + 10);
+    return 36;
+}
+
+// log2(base) for the bases that are powers of two, 0 for the others
+static unsigned pow2_bits(unsigned base) {
+    return (base & (base - 1)) == 0 ? static_cast<unsigned>(max_bit(base)) : 0;
+}
+
+// the largest power of the base that fits in a limb, and how many digits it covers
+static size_t chunk_digits(unsigned base, ui &big_base) {
+    size_t k = 1;
+    big_base = base;
+    while ((ull) big_base * base <= UMAX) {
+        big_base *= base;
+        k++;
     }
+    return k;
+}
 
-    std::string res;
-    big_integer temp(a);
-    bool neg = temp.sign_;
-    temp.sign_ = false;
+// pow[i] = big_base^(2^i) for every i up to the one whose chunk << i reaches len digits, or
+// whose square has more limbs than n
+std::vector<big_integer> big_integer::chunk_powers(unsigned base, size_t len, size_t n) {
+    ui big_base;
+    size_t chunk = chunk_digits(base, big_base);
+    std::vector<big_integer> pow(1, big_integer(big_base));
+    while ((chunk << pow.size()) < len && 2 * pow.back().size_ - 1 <= n)
+        pow.push_back(pow.back() * pow.back());
+    return pow;
+}
 
-    while (temp > 0) {
-        big_integer r;
-        r = temp % 10;
-        temp /= 10;
-        res += '0' + r.data_[0];
+big_integer big_integer::parse(char const *s, size_t len, unsigned base) {
+    if (unsigned bits = pow2_bits(base)) {
+        // each digit is a group of bits, put in place from the low end
+        size_t n = std::max<size_t>(1, (len * bits + SHIFT - 1) / SHIFT);
+        my_vector d(n, 0);
+        size_t pos = 0;
+        for (size_t i = len; i-- > 0; pos += bits) {
+            ull v = (ull) digit_value(s[i]) << (pos % SHIFT);
+            d[pos / SHIFT] |= static_cast<ui>(v);
+            if (pos % SHIFT + bits > SHIFT)
+                d[pos / SHIFT + 1] |= static_cast<ui>(v >> SHIFT);
+        }
+        return adopt(d, n, false);
     }
+    if (len <= FROM_STRING_DC_THRESHOLD)
+        return from_digits(s, len, base, std::vector<big_integer>());
+    return from_digits(s, len, base, chunk_powers(base, len, SIZE_MAX));
+}
 
-    if (neg) {
-        res += '-';
+// The value of the digits s[0, len). Short strings are read a limb-sized chunk of digits at
+// a time and folded in with a multiplication and an addition of single limbs; longer ones
+// are split before their last chunk * 2^k digits, the high part multiplied by pow[k]
+big_integer big_integer::from_digits(char const *s, size_t len, unsigned base, std::vector<big_integer> const &pow) {
+    ui big_base;
+    size_t chunk = chunk_digits(base, big_base);
+    if (len <= FROM_STRING_DC_THRESHOLD) {
+        my_vector d(len / chunk + 2, 0);
+        size_t n = 1;
+        for (size_t i = 0; i < len;) {
+            ui c = 0;
+            for (size_t end = i + (i == 0 && len % chunk ? len % chunk : chunk); i < end; i++)
+                c = c * base + digit_value(s[i]);
+            ui hi = limbs::mul_1(d.data(), d.data(), n, big_base);
+            hi += limbs::add_1(d.data(), d.data(), n, c);
+            if (hi != 0)
+                d[n++] = hi;
+        }
+        return adopt(d, n, false);
     }
-    reverse(res.begin(), res.end());
+    size_t k = 0;
+    while ((chunk << (k + 1)) < len)
+        k++;
+    size_t low = chunk << k;
+    big_integer r = from_digits(s, len - low, base, pow);
+    r *= pow[k];
+    r += from_digits(s + len - low, low, base, pow);
+    return r;
+}
+
+// Where to_digits puts the digits: a buffer that has to hold them all, or, with a stream, one
+// that is written out whenever it fills up
+struct big_integer::digit_sink {
+    char *first;
+    char *out;
+    char *last;
+    std::ostream *stream;
+
+    bool put(char const *p, size_t n) {
+        if (static_cast<size_t>(last - out) < n) {
+            if (!stream)
+                return false;
+            flush();
+        }
+        if (static_cast<size_t>(last - out) < n)
+            stream->write(p, static_cast<std::streamsize>(n));
+        else
+            out = std::copy(p, p + n, out);
+        return true;
+    }
+
+    void flush() {
+        stream->write(first, out - first);
+        out = first;
+    }
+
+    // the chunk digits of c, or only its significant ones when pad is false
+    bool put_chunk(ui c, bool pad, unsigned base, size_t chunk) {
+        char buf[32];
+        size_t i = chunk;
+        do {
+            buf[--i] = DIGITS[c % base];
+            c /= base;
+        } while (c != 0 || (pad && i > 0));
+        return put(buf + i, chunk - i);
+    }
+};
+
+// Puts the digits of 0 <= x < pow[k], where pow[i] = big_base^(2^i): exactly chunk * 2^k
+// of them with leading zeros when pad is set. Long numbers are split by pow[k - 1] and both
+// halves converted the same way, short ones take a chunk of digits per single-limb division.
+// Stops with false as soon as the digits do not fit
+bool big_integer::to_digits(digit_sink &out, big_integer const &x, unsigned base,
+                            std::vector<big_integer> const &pow, size_t k, bool pad) {
+    if (k == 0 || x.size_ <= TO_STRING_DC_THRESHOLD) {
+        ui big_base;
+        size_t chunk = chunk_digits(base, big_base);
+        big_integer t(x);
+        std::vector<ui> chunks;
+        while (t != 0)
+            chunks.push_back(t.divrem_small(big_base));
+        if (pad)
+            chunks.resize((size_t) 1 << k, 0);
+        for (size_t i = chunks.size(); i-- > 0;)
+            if (!out.put_chunk(chunks[i], pad || i + 1 < chunks.size(), base, chunk))
+                return false;
+        return true;
+    }
+    if (!pad && abs_compare(x, pow[k - 1]) == -1)
+        return to_digits(out, x, base, pow, k - 1, false);
+    std::pair<big_integer, big_integer> qr = divmod(x, pow[k - 1]);
+    return to_digits(out, qr.first, base, pow, k - 1, pad)
+           && to_digits(out, qr.second, base, pow, k - 1, true);
+}
+
+// the digits of |a| for a != 0
+bool big_integer::put_digits(digit_sink &out, big_integer const &a, unsigned base) {
+    big_integer x(a);
+    x.sign_ = false;
+    // x has fewer limbs than the square of the last power, so it is below it
+    std::vector<big_integer> pow;
+    if (x.size_ > TO_STRING_DC_THRESHOLD)
+        pow = chunk_powers(base, SIZE_MAX, x.size_);
+    return to_digits(out, x, base, pow, pow.size(), false);
+}
+
+size_t digits_upper_bound(big_integer const &a, int base) {
+    if (base < 2 || base > 36)
+        throw "BASE";
+    if (a == 0)
+        return 1;
+    size_t bits = big_integer::bit_length(a);
+    size_t sign = a.sign_ ? 1 : 0;
+    if (unsigned b = pow2_bits(static_cast<unsigned>(base)))
+        return sign + (bits + b - 1) / b;
+    // bits * log_base(2) rounded down, plus one for the top digit and one for rounding errors
+    return sign + static_cast<size_t>(static_cast<double>(bits) * std::log(2.0) / std::log(base)) + 2;
+}
+
+std::to_chars_result to_chars(char *first, char *last, big_integer const &a, int base) {
+    if (base < 2 || base > 36)
+        return {last, std::errc::invalid_argument};
+    if (first == last)
+        return {last, std::errc::value_too_large};
+    if (a == 0) {
+        *first = '0';
+        return {first + 1, std::errc()};
+    }
+    if (a.sign_) {
+        *first++ = '-';
+    }
+
+    if (unsigned bits = pow2_bits(static_cast<unsigned>(base))) {
+        // the digits are groups of bits, read from the top
+        ui const *d = a.data_.data();
+        size_t n = (big_integer::bit_length(a) + bits - 1) / bits;
+        if (static_cast<size_t>(last - first) < n)
+            return {last, std::errc::value_too_large};
+        for (size_t i = n; i-- > 0;) {
+            size_t pos = i * bits;
+            ull v = d[pos / SHIFT] >> (pos % SHIFT);
+            if (pos % SHIFT + bits > SHIFT && pos / SHIFT + 1 < a.size_)
+                v |= (ull) d[pos / SHIFT + 1] << (SHIFT - pos % SHIFT);
+            *first++ = DIGITS[v & (base - 1)];
+        }
+        return {first, std::errc()};
+    }
+
+    big_integer::digit_sink out = {first, first, last, nullptr};
+    if (!big_integer::put_digits(out, a, static_cast<unsigned>(base)))
+        return {last, std::errc::value_too_large};
+    return {out.out, std::errc()};
+}
+
+std::from_chars_result from_chars(char const *first, char const *last, big_integer &a, int base) {
+    if (base < 2 || base > 36)
+        return {first, std::errc::invalid_argument};
+    char const *p = first;
+    bool sign = p != last && *p == '-';
+    if (sign) {
+        p++;
+    }
+    char const *digits = p;
+    while (p != last && digit_value(*p) < static_cast<ui>(base))
+        p++;
+    if (p == digits)
+        return {first, std::errc::invalid_argument};
+    a = big_integer::parse(digits, static_cast<size_t>(p - digits), static_cast<unsigned>(base));
+    if (a != 0)
+        a.sign_ = sign;
+    return {p, std::errc()};
+}
+
+std::string to_string(big_integer const &a) {
+    return to_string(a, 10);
+}
+
+std::string to_string(big_integer const &a, int base) {
+    if (base < 2 || base > 36)
+        throw "BASE";
+    std::string res(digits_upper_bound(a, base), '\0');
+    char *first = &res[0];
+    res.resize(static_cast<size_t>(to_chars(first, first + res.size(), a, base).ptr - first));
     return res;
 }
 
 std::ostream &operator<<(std::ostream &s, big_integer const &a) {
-    return s << to_string(a);
+    // padding to a width needs the length first
+    if (s.width() != 0 || a == 0)
+        return s << to_string(a);
+
+    // the digits go out in blocks as the conversion produces them, from the top
+    char buf[4096];
+    big_integer::digit_sink out = {buf, buf, buf + sizeof buf, &s};
+    if (a.sign_) {
+        *out.out++ = '-';
+    }
+    big_integer::put_digits(out, a, 10);
+    out.flush();
+    return s;
+}
+
+std::istream &operator>>(std::istream &s, big_integer &a) {
+    std::istream::sentry ok(s);
+    if (!ok)
+        return s;
+    typedef std::char_traits<char> traits;
+    std::streambuf *in = s.rdbuf();
+    int c = in->sgetc();
+    bool sign = c == '-';
+    if (sign) {
+        c = in->snextc();
+    }
+
+    // The digits are parsed in blocks of 9 * 2^READ_BLOCK_LEVEL as they come. Parsed blocks
+    // are joined in pairs of equal length like the carries of a binary counter, so parts
+    // holds numbers of decreasing 9 * 2^level digits
+    size_t const block = (size_t) 9 << big_integer::READ_BLOCK_LEVEL;
+    std::vector<big_integer> pow(1, big_integer(1000000000));
+    while (pow.size() < big_integer::READ_BLOCK_LEVEL)
+        pow.push_back(pow.back() * pow.back());
+    std::vector<std::pair<big_integer, size_t>> parts;
+    char digits[block];
+    size_t len = 0;
+    bool any = false;
+    for (; c != traits::eof() && '0' <= c && c <= '9'; c = in->snextc()) {
+        any = true;
+        digits[len++] = static_cast<char>(c);
+        if (len < block)
+            continue;
+        big_integer v = big_integer::from_digits(digits, len, 10, pow);
+        size_t level = big_integer::READ_BLOCK_LEVEL;
+        for (; !parts.empty() && parts.back().second == level; level++) {
+            if (pow.size() == level)
+                pow.push_back(pow.back() * pow.back());
+            v += parts.back().first * pow[level];
+            parts.pop_back();
+        }
+        parts.emplace_back(std::move(v), level);
+        len = 0;
+    }
+    if (c == traits::eof())
+        s.setstate(std::ios_base::eofbit);
+    if (!any) {
+        s.setstate(std::ios_base::failbit);
+        return s;
+    }
+
+    // the digits after the last full block, then the parts from the shortest up
+    big_integer v = big_integer::from_digits(digits, len, 10, pow);
+    big_integer scale = 1;
+    for (size_t i = 0; i < len; i++)
+        scale *= 10;
+    for (size_t i = parts.size(); i-- > 0;) {
+        v += parts[i].first * scale;
+        if (i > 0)
+            scale *= pow[parts[i].second];
+    }
+    if (v != 0)
+        v.sign_ = sign;
+    big_integer::swap(a, v);
+    return s;
 }
\ No newline at end of file
@@ -3,11 +3,15 @@
 
 #include "my_vector.h"
 #include <iosfwd>
+#include <charconv>
 #include <cstdint>
 #include <utility>
+#include <type_traits>
 #include <gmp.h>
 #include <vector>
 
+struct big_divisor;
+
 struct big_integer
 {
 private:
@@ -18,12 +22,22 @@ public:
     big_integer(big_integer const& other) = default;
     big_integer(int a);
     big_integer(ui a);
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    big_integer(T a) : big_integer(from_small(magnitude(a), negative(a))) {}
     explicit big_integer(std::string const& str);
+    // digits in a base from 2 to 36, letters of either case for the digits above 9
+    big_integer(std::string const& str, int base);
     ~big_integer() = default;
 
     big_integer& operator=(big_integer const& other);
 
     friend std::string to_string(big_integer const& a);
+    friend std::string to_string(big_integer const& a, int base);
+    friend size_t digits_upper_bound(big_integer const& a, int base);
+    friend std::to_chars_result to_chars(char* first, char* last, big_integer const& a, int base);
+    friend std::from_chars_result from_chars(char const* first, char const* last, big_integer& a, int base);
+    friend std::ostream& operator<<(std::ostream& s, big_integer const& a);
+    friend std::istream& operator>>(std::istream& s, big_integer& a);
 
     big_integer& operator+=(big_integer const& rhs);
     big_integer& operator-=(big_integer const& rhs);
@@ -31,6 +45,64 @@ public:
     big_integer& operator/=(big_integer const& rhs);
     big_integer& operator%=(big_integer const& rhs);
 
+    // machine-word operands skip the conversion to big_integer and use single-limb kernels
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    big_integer& operator+=(T rhs) { return add_small(magnitude(rhs), negative(rhs)); }
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    big_integer& operator-=(T rhs) { return add_small(magnitude(rhs), !negative(rhs)); }
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    big_integer& operator*=(T rhs) { return mul_small(magnitude(rhs), negative(rhs)); }
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    big_integer& operator/=(T rhs) { return div_small(magnitude(rhs), negative(rhs)); }
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    big_integer& operator%=(T rhs) { return mod_small(magnitude(rhs), negative(rhs)); }
+
+    // *this += a * b and *this -= a * b, accumulating the product straight into *this
+    big_integer& addmul(big_integer const& a, big_integer const& b);
+    big_integer& submul(big_integer const& a, big_integer const& b);
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    big_integer& addmul(big_integer const& a, T b) { return addmul_small(a, magnitude(b), negative(b)); }
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    big_integer& submul(big_integer const& a, T b) { return addmul_small(a, magnitude(b), !negative(b)); }
+
+    // *this /= d, returning |*this % d| as a plain number
+    uint32_t divrem_small(uint32_t d);
+
+    // quotient and remainder of truncating division, a == q * b + r with r taking the sign of a
+    static std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b);
+    // the same for a divisor prepared beforehand, when many numbers are divided by it
+    static std::pair<big_integer, big_integer> divmod(big_integer const& a, big_divisor const& b);
+    big_integer& operator/=(big_divisor const& rhs);
+    big_integer& operator%=(big_divisor const& rhs);
+    // divmod rounding the quotient toward minus infinity (r takes the sign of b), toward plus
+    // infinity (r takes the opposite sign) and Euclidean division (0 <= r < |b|)
+    static std::pair<big_integer, big_integer> fdiv_qr(big_integer const& a, big_integer const& b);
+    static std::pair<big_integer, big_integer> cdiv_qr(big_integer const& a, big_integer const& b);
+    static std::pair<big_integer, big_integer> ediv_qr(big_integer const& a, big_integer const& b);
+
+    // whether d divides *this without a remainder; 0 divides only 0
+    bool divisible_by(big_integer const& d) const;
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    bool divisible_by(T d) const { return divisible_small(magnitude(d)); }
+
+    // a / 2^k rounded toward zero and toward minus infinity, and the remainder a % 2^k
+    // of the first, which takes the sign of a
+    static big_integer tdiv_q_2exp(big_integer const& a, size_t k);
+    static big_integer fdiv_q_2exp(big_integer const& a, size_t k);
+    static big_integer mod_2exp(big_integer const& a, size_t k);
+
+    // a / b when b is known to divide a, roughly twice as fast as divmod; for any other a
+    // the result is meaningless
+    static big_integer divexact(big_integer const& a, big_integer const& b);
+
+    // floor(2^precision / |x|) with the sign of x, by Newton's iteration
+    static big_integer reciprocal(big_integer const& x, size_t precision);
+
+    // the low n 32-bit limbs of |a * b| and the part above them, |a * b| / 2^(32 n);
+    // both take the sign of a * b
+    static big_integer mul_low(big_integer const& a, big_integer const& b, size_t n);
+    static big_integer mul_high(big_integer const& a, big_integer const& b, size_t n);
+
     big_integer& operator&=(big_integer const& rhs);
     big_integer& operator|=(big_integer const& rhs);
     big_integer& operator^=(big_integer const& rhs);
@@ -55,31 +127,135 @@ public:
     friend bool operator<=(big_integer const& a, big_integer const& b);
     friend bool operator>=(big_integer const& a, big_integer const& b);
 
+#define BIG_INTEGER_COMPARE_SMALL(op)                                                   \
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>       \
+    friend bool operator op(big_integer const& a, T b) {                                \
+        return compare_small(a, magnitude(b), negative(b)) op 0;                        \
+    }                                                                                   \
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>       \
+    friend bool operator op(T a, big_integer const& b) {                                \
+        return 0 op compare_small(b, magnitude(a), negative(a));                        \
+    }
+
+    BIG_INTEGER_COMPARE_SMALL(==)
+    BIG_INTEGER_COMPARE_SMALL(!=)
+    BIG_INTEGER_COMPARE_SMALL(<)
+    BIG_INTEGER_COMPARE_SMALL(>)
+    BIG_INTEGER_COMPARE_SMALL(<=)
+    BIG_INTEGER_COMPARE_SMALL(>=)
+
+#undef BIG_INTEGER_COMPARE_SMALL
+
 private:
+    friend struct big_divisor;
+
     my_vector data_;
     bool sign_ = 0;
     size_t size_ = 0;
 
     big_integer& clear(big_integer &a, size_t size);
     big_integer& resize(size_t capacity);
+    void grow(size_t size);
     big_integer& abs_add(big_integer const& rhs, bool sign);
     big_integer& abs_sub(big_integer const& rhs, bool sign, int comp);
 
     template<class FunctorT>
     big_integer& apply_bitwise_operation(big_integer const & rhs, FunctorT functor);
 
-    void add_big_int(my_vector &a, ui x, size_t index);
     static void swap(big_integer &a, big_integer &b);
     static int abs_compare(big_integer const& a, big_integer const& b);
     static void normalize(big_integer &a);
-    big_integer inverse(big_integer a);
+    static my_vector inverse(big_integer const& a, size_t n);
+    static size_t bit_length(big_integer const& a);
+    static size_t trailing_zeros(big_integer const& a);
+    void abs_shr(size_t k);
+
+    // reciprocals of this many limbs are refined by Newton's iteration from one of half the
+    // length
+    static size_t const NEWTON_RECIP_THRESHOLD = 2000;
+    static big_integer recip_approx(big_integer const& d, size_t k);
+    // exact division is left to divmod when quotient and divisor have this many limbs and
+    // the divisor is shorter than twice the quotient; Hensel's division only uses as many
+    // limbs of the divisor as the quotient has
+    static size_t const DIVEXACT_DIV_THRESHOLD = 150;
+    static big_integer adopt(my_vector &v, size_t n, bool neg);
+    static std::pair<big_integer, big_integer> divmod_1(big_integer const& a, ui d, unsigned shift, ui dinv, bool neg);
+    static std::pair<big_integer, big_integer> divmod_knuth(big_integer const& a, ui const* d, size_t m,
+                                                            unsigned shift, ui dinv, bool neg);
+    static std::pair<big_integer, big_integer> divmod_barrett(big_integer const& a, big_divisor const& b);
+    static void round_away(std::pair<big_integer, big_integer> &qr, big_integer const& b, bool neg);
+    // to_string splits numbers of more than this many limbs in two by a power of the base,
+    // and the string constructors split strings of more than this many digits. Bases that
+    // are powers of two need neither, their digits are groups of bits
+    static size_t const TO_STRING_DC_THRESHOLD = 30;
+    static size_t const FROM_STRING_DC_THRESHOLD = 1000;
+    static std::vector<big_integer> chunk_powers(unsigned base, size_t len, size_t n);
+    // operator>> parses its input in blocks of 9 * 2^READ_BLOCK_LEVEL digits
+    static size_t const READ_BLOCK_LEVEL = 7;
+    struct digit_sink;
+    static bool to_digits(digit_sink &out, big_integer const& x, unsigned base,
+                          std::vector<big_integer> const& pow, size_t k, bool pad);
+    static bool put_digits(digit_sink &out, big_integer const& a, unsigned base);
+    static big_integer parse(char const* s, size_t len, unsigned base);
+    static big_integer from_digits(char const* s, size_t len, unsigned base, std::vector<big_integer> const& pow);
 
+    template<typename T>
+    static ull magnitude(T x) {
+        if constexpr (std::is_signed<T>::value)
+            return x < 0 ? 0 - static_cast<ull>(x) : static_cast<ull>(x);
+        else
+            return static_cast<ull>(x);
+    }
+
+    template<typename T>
+    static bool negative(T x) {
+        if constexpr (std::is_signed<T>::value)
+            return x < 0;
+        else
+            return false;
+    }
+
+    static big_integer from_small(ull mag, bool neg);
+    static int compare_small(big_integer const& a, ull mag, bool neg);
+    big_integer& add_small(ull mag, bool neg);
+    big_integer& mul_small(ull mag, bool neg);
+    big_integer& div_small(ull mag, bool neg);
+    big_integer& mod_small(ull mag, bool neg);
+    bool divisible_small(ull mag) const;
+    big_integer& addmul_small(big_integer const& a, ull mag, bool neg);
+    big_integer& add_product(big_integer const& a, ui const* b, size_t bn, bool neg);
+
+};
+
+// A divisor with what division needs from it worked out once: its limbs shifted to have the
+// top bit set, the reciprocal of their top two limbs and, from BARRETT_DIV_THRESHOLD limbs
+// on, floor(2^(64 m) / |d|) for Barrett's reduction
+struct big_divisor
+{
+    big_divisor(big_integer const& d);
+
+    big_integer const& value() const { return value_; }
+
+private:
+    typedef uint32_t ui;
+    friend struct big_integer;
+
+    static size_t const BARRETT_DIV_THRESHOLD = 1000;
+
+    big_integer value_;
+    my_vector norm_;
+    unsigned shift_;
+    ui dinv_;
+    big_integer barrett_;
 };
+
 big_integer operator+(big_integer a, big_integer const& b);
 big_integer operator-(big_integer a, big_integer const& b);
 big_integer operator*(big_integer a, big_integer const& b);
 big_integer operator/(big_integer a, big_integer const& b);
 big_integer operator%(big_integer a, big_integer const& b);
+big_integer operator/(big_integer a, big_divisor const& b);
+big_integer operator%(big_integer a, big_divisor const& b);
 
 big_integer operator&(big_integer a, big_integer const& b);
 big_integer operator|(big_integer a, big_integer const& b);
@@ -88,6 +264,27 @@ big_integer operator^(big_integer a, big_integer const& b);
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
 
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator+(big_integer a, T b) { return a += b; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator+(T a, big_integer b) { return b += a; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator-(big_integer a, T b) { return a -= b; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator-(T a, big_integer const& b) { return big_integer(a) -= b; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator*(big_integer a, T b) { return a *= b; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator*(T a, big_integer b) { return b *= a; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator/(big_integer a, T b) { return a /= b; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator/(T a, big_integer const& b) { return big_integer(a) /= b; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator%(big_integer a, T b) { return a %= b; }
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+big_integer operator%(T a, big_integer const& b) { return big_integer(a) %= b; }
+
 bool operator==(big_integer const& a, big_integer const& b);
 bool operator!=(big_integer const& a, big_integer const& b);
 bool operator<(big_integer const& a, big_integer const& b);
@@ -96,6 +293,17 @@ bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
 
 std::string to_string(big_integer const& a);
+std::string to_string(big_integer const& a, int base);
+// the most characters to_chars can write for a in this base, the sign included; throws for
+// a base outside [2, 36], as to_string does
+size_t digits_upper_bound(big_integer const& a, int base = 10);
+// like std::to_chars and std::from_chars: no allocation for the digits, a minus sign only,
+// and errors reported in ec rather than thrown. to_chars fails with value_too_large when the
+// digits do not fit, from_chars with invalid_argument when there are no digits to read
+std::to_chars_result to_chars(char* first, char* last, big_integer const& a, int base = 10);
+std::from_chars_result from_chars(char const* first, char const* last, big_integer& a, int base = 10);
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
+// reads an optional minus sign and decimal digits, failing when there are none
+std::istream& operator>>(std::istream& s, big_integer& a);
 
 #endif // BIG_INTEGER_H
\ No newline at end of file
@@ -1,11 +1,14 @@
 #include <algorithm>
+#include <iomanip>
 #include <cassert>
 #include <cstdlib>
+#include <sstream>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
+#include "limbs.h"
 
 TEST(correctness, two_plus_two)
 {
@@ -607,6 +610,54 @@ TEST(correctness, string_conv)
     EXPECT_EQ(to_string(big_integer("-1000000000000000")), "-1000000000000000");
 }
 
+TEST(correctness, int_min)
+{
+    EXPECT_EQ(to_string(big_integer(INT_MIN)), "-2147483648");
+    EXPECT_EQ(big_integer(INT_MIN) + big_integer(INT_MAX), big_integer(-1));
+}
+
+TEST(correctness, bitwise_negative)
+{
+    big_integer p64 = big_integer(1) << 64;
+    EXPECT_EQ(big_integer(-1) & big_integer(5), big_integer(5));
+    EXPECT_EQ(-p64 & ((big_integer(1) << 65) - big_integer(1)), p64);
+    EXPECT_EQ(-p64 | big_integer(1), big_integer(1) - p64);
+    EXPECT_EQ(big_integer(-5) ^ big_integer(3), big_integer(-8));
+    EXPECT_EQ(-(big_integer(1) << 32) ^ big_integer(-1), (big_integer(1) << 32) - big_integer(1));
+    EXPECT_EQ(-(big_integer(1) << 96) & -(big_integer(1) << 32), -(big_integer(1) << 96));
+}
+
+TEST(correctness, add_carry_out_of_longer)
+{
+    big_integer a = big_integer(UINT32_MAX);
+    for (int i = 0; i < 5; i++)
+        a = a * big_integer(UINT32_MAX);
+    big_integer b = a;
+    b += a;
+    EXPECT_EQ(b, a * big_integer(2));
+}
+
+TEST(correctness, sub_borrow_through_max_limb)
+{
+    EXPECT_EQ((big_integer(1) << 64) - ((big_integer(1) << 64) - big_integer(1)), big_integer(1));
+    EXPECT_EQ((big_integer(1) << 160) - ((big_integer(1) << 128) - big_integer(1)),
+              (big_integer(1) << 160) - (big_integer(1) << 128) + big_integer(1));
+}
+
+TEST(correctness, shift_whole_limbs)
+{
+    // five limbs
+    big_integer x("987654321098765432109876543210987654321098765432");
+    EXPECT_EQ(x >> 160, 0);
+    EXPECT_EQ(x >> 200, 0);
+    EXPECT_EQ((x << 64) >> 64, x);
+    EXPECT_EQ((x << 77) >> 77, x);
+    EXPECT_EQ((x >> 128) << 128, x - x % (big_integer(1) << 128));
+    EXPECT_EQ((big_integer(1) << 64) >> 96, 0);
+    EXPECT_EQ(-(big_integer(1) << 64) >> 100, -1);
+    EXPECT_EQ(big_integer(UINT32_MAX) << 32, big_integer(UINT64_MAX) - UINT32_MAX);
+}
+
 
 namespace
 {
@@ -734,4 +785,773 @@ TEST(correctness, div_randomized)
         EXPECT_GE(residue, 0);
         EXPECT_LT(residue, divisor);
     }
-}
\ No newline at end of file
+}
+
+namespace
+{
+    std::vector<uint32_t> rand_limbs(size_t size)
+    {
+        std::vector<uint32_t> result(size);
+        for (size_t i = 0; i != size; ++i)
+            result[i] = static_cast<uint32_t>(rand()) << 1 ^ static_cast<uint32_t>(rand());
+        return result;
+    }
+
+    big_integer from_limbs(uint32_t const* limbs, size_t size)
+    {
+        if (size == 1)
+            return big_integer(limbs[0]);
+        size_t half = size / 2;
+        return (from_limbs(limbs + half, size - half) << (32 * half)) + from_limbs(limbs, half);
+    }
+
+    big_integer from_limbs(std::vector<uint32_t> const& limbs)
+    {
+        return from_limbs(limbs.data(), limbs.size());
+    }
+
+    // schoolbook product built only from single-limb multiplications
+    big_integer mul_reference(big_integer const& a, std::vector<uint32_t> const& b)
+    {
+        big_integer result;
+        for (size_t i = b.size(); i-- != 0;)
+        {
+            result <<= 32;
+            result += a * big_integer(b[i]);
+        }
+        return result;
+    }
+
+    void check_mul(std::vector<uint32_t> const& a, std::vector<uint32_t> const& b)
+    {
+        big_integer x = from_limbs(a);
+        big_integer y = from_limbs(b);
+        big_integer expected = mul_reference(x, b);
+        EXPECT_EQ(x * y, expected);
+        EXPECT_EQ(y * -x, -expected);
+    }
+
+    // a == q * b + r with |r| < |b| and r taking the sign of a
+    void check_qr(big_integer const& a, big_integer const& b, big_integer const& q, big_integer const& r)
+    {
+        EXPECT_EQ(q * b + r, a);
+        EXPECT_LT(r >= 0 ? r : -r, b >= 0 ? b : -b);
+        EXPECT_TRUE(r == 0 || (r < 0) == (a < 0));
+    }
+
+    void check_divmod(big_integer const& a, big_integer const& b)
+    {
+        std::pair<big_integer, big_integer> qr = big_integer::divmod(a, b);
+        check_qr(a, b, qr.first, qr.second);
+        check_qr(a, b, a / b, a % b);
+    }
+
+    // operands of random limbs, one pair for each pair of lengths
+    std::vector<std::pair<big_integer, big_integer>> rand_pairs(std::initializer_list<std::pair<size_t, size_t>> sizes)
+    {
+        std::vector<std::pair<big_integer, big_integer>> result;
+        for (auto const& size : sizes)
+            result.emplace_back(from_limbs(rand_limbs(size.first)), from_limbs(rand_limbs(size.second)));
+        return result;
+    }
+}
+
+TEST(correctness, mul_karatsuba)
+{
+    size_t const sizes[] = {31, 32, 33, 47, 64, 100, 257};
+    for (size_t an : sizes)
+        for (size_t bn : sizes)
+            check_mul(rand_limbs(an), rand_limbs(bn));
+
+    check_mul(std::vector<uint32_t>(300, UINT32_MAX), std::vector<uint32_t>(300, UINT32_MAX));
+    check_mul(std::vector<uint32_t>(500, UINT32_MAX), std::vector<uint32_t>(70, UINT32_MAX));
+}
+
+TEST(correctness, mul_toom)
+{
+    size_t const sizes[][2] = {{120, 120}, {121, 82}, {200, 150}, {300, 300}, {301, 227},
+                               {400, 399}, {1000, 760}, {1500, 1500}, {2000, 1300}};
+    for (auto const& size : sizes)
+    {
+        check_mul(rand_limbs(size[0]), rand_limbs(size[1]));
+        check_mul(rand_limbs(size[1]), rand_limbs(size[0]));
+    }
+
+    check_mul(std::vector<uint32_t>(1200, UINT32_MAX), std::vector<uint32_t>(1200, UINT32_MAX));
+    check_mul(std::vector<uint32_t>(1200, UINT32_MAX), std::vector<uint32_t>(950, UINT32_MAX));
+}
+
+TEST(correctness, mul_ntt)
+{
+    // the reference splits y into halves that are multiplied below the NTT threshold
+    size_t const sizes[][2] = {{45000, 41000}, {120000, 40500}};
+    for (auto const& size : sizes)
+    {
+        big_integer x = from_limbs(rand_limbs(size[0]));
+        size_t half = size[1] / 2;
+        big_integer lo = from_limbs(rand_limbs(half));
+        big_integer hi = from_limbs(rand_limbs(size[1] - half));
+        big_integer y = (hi << (32 * half)) + lo;
+
+        EXPECT_EQ(x * y, ((x * hi) << (32 * half)) + x * lo);
+        EXPECT_EQ(y * y, ((hi * hi) << (64 * half)) + ((hi * lo) << (32 * half + 1)) + lo * lo);
+    }
+
+    std::vector<uint32_t> ones(41000, UINT32_MAX);
+    big_integer z = from_limbs(ones);
+    big_integer w = from_limbs(ones.data(), 20500);
+    EXPECT_EQ(z * z, ((z * w) << (32 * 20500)) + z * w);
+}
+
+TEST(correctness, sqr)
+{
+    size_t const sizes[] = {1, 2, 20, 47, 48, 60, 150, 250, 700, 2000};
+    for (size_t n : sizes)
+    {
+        std::vector<uint32_t> limbs = rand_limbs(n);
+        big_integer x = from_limbs(limbs);
+        big_integer expected = mul_reference(x, limbs);
+
+        EXPECT_EQ(x * x, expected);
+        EXPECT_EQ(-x * x, -expected);
+        x *= x;
+        EXPECT_EQ(x, expected);
+    }
+
+    std::vector<uint32_t> ones(900, UINT32_MAX);
+    big_integer y = from_limbs(ones);
+    EXPECT_EQ(y * y, mul_reference(y, ones));
+}
+
+TEST(correctness, mul_unbalanced)
+{
+    size_t const sizes[][2] = {{100, 49}, {1000, 60}, {1999, 1000}, {2000, 1000}, {5000, 451}, {12000, 1500}};
+    for (auto const& size : sizes)
+    {
+        check_mul(rand_limbs(size[0]), rand_limbs(size[1]));
+        check_mul(rand_limbs(size[1]), rand_limbs(size[0]));
+    }
+
+    check_mul(std::vector<uint32_t>(3000, UINT32_MAX), std::vector<uint32_t>(700, UINT32_MAX));
+}
+
+TEST(correctness, small_operands)
+{
+    int64_t const values[] = {0, 1, -1, 7, -7, INT32_MIN, INT32_MAX, (int64_t) UINT32_MAX, -(int64_t) UINT32_MAX,
+                              (int64_t) 1 << 32, 123456789012345, -987654321098765, INT64_MAX, INT64_MIN};
+    big_integer const bigs[] = {0, 5, -5, big_integer("4294967295"), big_integer("-4294967296"),
+                                big_integer("18446744073709551616"), big_integer("-123456789012345678901234567890")};
+    for (big_integer const& x : bigs)
+    {
+        for (int64_t v : values)
+        {
+            big_integer y(std::to_string(v));
+            EXPECT_EQ(big_integer(v), y);
+            EXPECT_EQ(x + v, x + y);
+            EXPECT_EQ(v + x, x + y);
+            EXPECT_EQ(x - v, x - y);
+            EXPECT_EQ(v - x, y - x);
+            EXPECT_EQ(x * v, x * y);
+            EXPECT_EQ(v * x, x * y);
+            EXPECT_EQ(x == v, x == y);
+            EXPECT_EQ(v < x, y < x);
+            EXPECT_EQ(x <= v, x <= y);
+            if (v != 0)
+            {
+                EXPECT_EQ(x / v, x / y);
+                EXPECT_EQ(x % v, x % y);
+            }
+            if (x != 0)
+            {
+                EXPECT_EQ(v / x, y / x);
+                EXPECT_EQ(v % x, y % x);
+            }
+        }
+    }
+
+    big_integer a = UINT64_MAX;
+    EXPECT_EQ(a, big_integer("18446744073709551615"));
+    a += 1u;
+    EXPECT_EQ(a, big_integer("18446744073709551616"));
+    a -= UINT64_MAX;
+    EXPECT_EQ(a, 1);
+    a *= -3;
+    a %= 2;
+    EXPECT_EQ(a, -1);
+    EXPECT_THROW(a /= 0, char const*);
+}
+
+TEST(correctness, addmul_submul)
+{
+    size_t const sizes[][3] = {{1, 1, 1}, {1, 30, 2}, {40, 30, 2}, {3, 100, 60}, {500, 100, 60}, {2, 70, 65}};
+    for (auto const& size : sizes)
+    {
+        big_integer const bigs[] = {from_limbs(rand_limbs(size[0])), from_limbs(rand_limbs(size[1])),
+                                    from_limbs(rand_limbs(size[2]))};
+        for (int signs = 0; signs < 8; signs++)
+        {
+            big_integer acc = signs & 1 ? -bigs[0] : bigs[0];
+            big_integer a = signs & 2 ? -bigs[1] : bigs[1];
+            big_integer b = signs & 4 ? -bigs[2] : bigs[2];
+
+            EXPECT_EQ(big_integer(acc).addmul(a, b), acc + a * b);
+            EXPECT_EQ(big_integer(acc).submul(a, b), acc - a * b);
+            EXPECT_EQ(big_integer(acc).addmul(b, a), acc + a * b);
+            EXPECT_EQ(big_integer(acc).addmul(a, -7), acc - a * 7);
+            EXPECT_EQ(big_integer(acc).submul(a, UINT64_MAX), acc - a * UINT64_MAX);
+            EXPECT_EQ(big_integer(acc).addmul(a, 0), acc);
+            EXPECT_EQ(big_integer(a * b).submul(a, b), 0);
+        }
+    }
+
+    big_integer x = from_limbs(rand_limbs(80));
+    big_integer y = x;
+    EXPECT_EQ(y.addmul(y, y), x + x * x);
+    y = x;
+    EXPECT_EQ(y.submul(y, 3), x - x * 3);
+}
+
+TEST(correctness, mul_low_high)
+{
+    size_t const sizes[][2] = {{1, 1}, {5, 3}, {60, 60}, {130, 120}, {300, 300}, {700, 250}, {1500, 1400}};
+    for (auto const& size : sizes)
+    {
+        std::vector<uint32_t> ones(size[0], UINT32_MAX);
+        big_integer const operands[][2] = {{from_limbs(rand_limbs(size[0])), from_limbs(rand_limbs(size[1]))},
+                                           {from_limbs(ones), -from_limbs(ones)}};
+        for (auto const& op : operands)
+        {
+            big_integer product = op[0] * op[1];
+            big_integer magnitude = product < 0 ? -product : product;
+            size_t const cuts[] = {0, 1, 2, 3, size[1] / 2, size[1], size[0] + size[1] / 3, size[0] + size[1] - 1,
+                                   size[0] + size[1] + 2};
+            for (size_t n : cuts)
+            {
+                big_integer high = magnitude >> static_cast<int>(32 * n);
+                big_integer low = magnitude - (high << static_cast<int>(32 * n));
+                if (product < 0)
+                {
+                    high = -high;
+                    low = -low;
+                }
+                EXPECT_EQ(big_integer::mul_high(op[0], op[1], n), high);
+                EXPECT_EQ(big_integer::mul_low(op[0], op[1], n), low);
+            }
+        }
+    }
+
+    big_integer x = from_limbs(rand_limbs(400));
+    EXPECT_EQ(big_integer::mul_high(x, x, 400), (x * x) >> (32 * 400));
+    EXPECT_EQ(big_integer::mul_low(x, x, 400), x * x - (big_integer::mul_high(x, x, 400) << (32 * 400)));
+}
+
+TEST(correctness, simd_kernels)
+{
+    // long carry and borrow chains: limbs that are all ones or zero, mixed with random ones
+    auto limbs_with_runs = [](size_t n)
+    {
+        std::vector<uint32_t> v = rand_limbs(n);
+        for (size_t i = 0; i < n; i++)
+            if (rand() % 3 == 0)
+                v[i] = rand() % 2 ? UINT32_MAX : 0;
+        return v;
+    };
+
+    size_t const sizes[] = {1, 7, 8, 9, 15, 16, 17, 33, 64, 100, 130};
+    limbs::isa const sets[] = {limbs::isa::avx2, limbs::isa::avx512};
+    for (size_t n : sizes)
+    {
+        std::vector<uint32_t> a = limbs_with_runs(n), b = limbs_with_runs(n);
+        std::vector<uint32_t> c = limbs_with_runs(n / 2 + 1);
+        std::vector<uint32_t> ones(n, UINT32_MAX), one(n, 0);
+        one[0] = 1;
+
+        limbs::set_isa(limbs::isa::scalar);
+        std::vector<uint32_t> sum(n), diff(n), wrap(n), prod(n + c.size()), sq(2 * n);
+        uint32_t sum_carry = limbs::add_n(sum.data(), a.data(), b.data(), n);
+        uint32_t diff_borrow = limbs::sub_n(diff.data(), a.data(), b.data(), n);
+        limbs::mul(prod.data(), a.data(), n, c.data(), c.size());
+        limbs::sqr(sq.data(), a.data(), n);
+
+        for (limbs::isa set : sets)
+        {
+            if (limbs::set_isa(set) != set)
+                continue;
+            std::vector<uint32_t> r(2 * n + c.size());
+            EXPECT_EQ(limbs::add_n(r.data(), a.data(), b.data(), n), sum_carry);
+            EXPECT_TRUE(std::equal(sum.begin(), sum.end(), r.begin()));
+            EXPECT_EQ(limbs::sub_n(r.data(), a.data(), b.data(), n), diff_borrow);
+            EXPECT_TRUE(std::equal(diff.begin(), diff.end(), r.begin()));
+            EXPECT_EQ(limbs::add_n(r.data(), ones.data(), one.data(), n), 1u);
+            EXPECT_TRUE(std::all_of(r.begin(), r.begin() + n, [](uint32_t x) { return x == 0; }));
+            EXPECT_EQ(limbs::sub_n(r.data(), r.data(), one.data(), n), 1u);
+            EXPECT_TRUE(std::equal(ones.begin(), ones.end(), r.begin()));
+            limbs::mul(r.data(), a.data(), n, c.data(), c.size());
+            EXPECT_TRUE(std::equal(prod.begin(), prod.end(), r.begin()));
+            limbs::sqr(r.data(), a.data(), n);
+            EXPECT_TRUE(std::equal(sq.begin(), sq.end(), r.begin()));
+        }
+    }
+
+    for (limbs::isa set : sets)
+    {
+        if (limbs::set_isa(set) != set)
+            continue;
+        check_mul(rand_limbs(1000), rand_limbs(700));
+        check_mul(std::vector<uint32_t>(300, UINT32_MAX), std::vector<uint32_t>(60, UINT32_MAX));
+    }
+    limbs::set_isa(limbs::best_isa());
+}
+
+TEST(correctness, divmod)
+{
+    for (auto const& [a, b] : rand_pairs({{1, 1}, {3, 1}, {2, 2}, {10, 3}, {50, 49}, {200, 60}, {300, 150}}))
+        for (int signs = 0; signs < 4; signs++)
+            check_divmod(signs & 1 ? -a : a, signs & 2 ? -b : b);
+
+    big_integer x("-1000000000000000000000000000000000");
+    std::pair<big_integer, big_integer> qr = big_integer::divmod(x, big_integer("7000000000000000000000000000000000"));
+    EXPECT_EQ(qr.first, 0);
+    EXPECT_EQ(qr.second, x);
+    qr = big_integer::divmod(x, x);
+    EXPECT_EQ(qr.first, 1);
+    EXPECT_EQ(qr.second, 0);
+    EXPECT_THROW(big_integer::divmod(x, 0), char const*);
+}
+
+TEST(correctness, div_corrections)
+{
+    // the quotient digit estimate is one too large and the window has to be added back
+    check_divmod(from_limbs(std::vector<uint32_t>{0, 0, 0x80000000u, 0x7fffffffu}),
+          from_limbs(std::vector<uint32_t>{1, 0, 0x80000000u}));
+    check_divmod(from_limbs(std::vector<uint32_t>{3, 0, 0x80000000u}), from_limbs(std::vector<uint32_t>{1, 0, 0x20000000u}));
+    check_divmod(from_limbs(std::vector<uint32_t>{0, 0xfffffffeu, 0x8000u}), from_limbs(std::vector<uint32_t>{0xffffu, 0x8000u}));
+
+    for (size_t m : {2, 3, 10, 40})
+    {
+        std::vector<uint32_t> top(m, 0), ones(m, UINT32_MAX);
+        top[m - 1] = 0x80000000u;
+        big_integer const divisors[] = {from_limbs(top), from_limbs(ones), from_limbs(top) + 1, from_limbs(ones) - 1};
+        for (big_integer const& d : divisors)
+        {
+            check_divmod(from_limbs(std::vector<uint32_t>(3 * m, UINT32_MAX)), d);
+            check_divmod(d * from_limbs(rand_limbs(2 * m)) + (d - 1), d);
+            check_divmod(d * from_limbs(std::vector<uint32_t>(m + 1, UINT32_MAX)) + (d - 1), d);
+        }
+    }
+}
+
+TEST(correctness, div_large)
+{
+    size_t const sizes[][2] = {{200, 100}, {1000, 400}, {1300, 1200}, {2500, 700}, {3000, 1000}, {4000, 130}};
+    for (auto const& size : sizes)
+    {
+        big_integer d = from_limbs(rand_limbs(size[1]));
+        check_divmod(from_limbs(rand_limbs(size[0])), d);
+        check_divmod(d * from_limbs(rand_limbs(size[0] - size[1])) + (d - 1), d);
+
+        std::vector<uint32_t> top(size[1], 0);
+        top.back() = 0x80000000u;
+        big_integer t = from_limbs(top);
+        check_divmod(from_limbs(std::vector<uint32_t>(size[0], UINT32_MAX)), t);
+        check_divmod(t * from_limbs(std::vector<uint32_t>(size[0] - size[1], UINT32_MAX)) + (t - 1), t);
+        check_divmod(from_limbs(std::vector<uint32_t>(size[0], UINT32_MAX)), from_limbs(std::vector<uint32_t>(size[1], UINT32_MAX)));
+    }
+}
+
+TEST(correctness, reciprocal)
+{
+    EXPECT_EQ(big_integer::reciprocal(3, 10), 341);
+    EXPECT_EQ(big_integer::reciprocal(-3, 10), -341);
+    EXPECT_EQ(big_integer::reciprocal(1024, 10), 1);
+    EXPECT_EQ(big_integer::reciprocal(1025, 10), 0);
+    EXPECT_THROW(big_integer::reciprocal(0, 10), char const*);
+
+    // the longer ones go through one or two Newton steps
+    size_t const sizes[][2] = {{1, 100}, {50, 3000}, {700, 5000}, {2100, 4500}, {1000, 9000}};
+    for (auto const& size : sizes)
+    {
+        big_integer d = from_limbs(rand_limbs(size[0]));
+        size_t k = size[1] * 32 + 5;
+        big_integer x = big_integer::reciprocal(d, k);
+        EXPECT_EQ(x, (big_integer(1) << static_cast<int>(k)) / d);
+        EXPECT_EQ(big_integer::reciprocal(-d, k), -x);
+
+        big_integer p = (big_integer(1) << static_cast<int>(k / 2)) - 1;
+        EXPECT_EQ(big_integer::reciprocal(p, k), (big_integer(1) << static_cast<int>(k)) / p);
+    }
+}
+
+TEST(correctness, big_divisor)
+{
+    EXPECT_THROW(big_divisor(0), char const*);
+    big_divisor seven(-7);
+    EXPECT_EQ(big_integer(100) / seven, -14);
+    EXPECT_EQ(big_integer(-100) % seven, -2);
+    EXPECT_EQ(big_integer(5) / seven, 0);
+    EXPECT_EQ(seven.value(), -7);
+
+    // the longest divisors go through Barrett's reduction
+    size_t const sizes[][2] = {{1, 3}, {2, 2}, {3, 20}, {40, 100}, {300, 1000}, {1200, 3000}, {1500, 1600}};
+    for (auto const& size : sizes)
+    {
+        big_integer b = from_limbs(rand_limbs(size[0]));
+        for (big_integer const& d : {b, -b, b + 1, (big_integer(1) << static_cast<int>(32 * size[0] - 1)) + 1})
+        {
+            big_divisor bd(d);
+            big_integer a = from_limbs(rand_limbs(size[1]));
+            for (big_integer const& x : {a, -a, d * a + (d - 1), d * a - 1, d - 1})
+            {
+                EXPECT_EQ(big_integer::divmod(x, bd), big_integer::divmod(x, d));
+                EXPECT_EQ(x / bd, x / d);
+                EXPECT_EQ(x % bd, x % d);
+            }
+        }
+    }
+}
+
+TEST(correctness, divrem_small)
+{
+    big_integer a("-1000000000000000000007");
+    EXPECT_EQ(a.divrem_small(10), 7u);
+    EXPECT_EQ(a, big_integer("-100000000000000000000"));
+    EXPECT_THROW(a.divrem_small(0), char const*);
+
+    uint32_t const divisors[] = {1, 2, 3, 10, 1000000000, 0x7fffffffu, 0x80000000u, 0x80000001u, UINT32_MAX};
+    for (size_t n : {1, 2, 5, 40})
+    {
+        big_integer x = from_limbs(rand_limbs(n));
+        for (uint32_t d : divisors)
+        {
+            for (big_integer const& y : {x, -x, from_limbs(std::vector<uint32_t>(n, UINT32_MAX)), x * d + (d - 1)})
+            {
+                big_integer q = y;
+                uint32_t r = q.divrem_small(d);
+                EXPECT_EQ(q * d + (y < 0 ? -big_integer(r) : big_integer(r)), y);
+                EXPECT_LT(r, d);
+                EXPECT_EQ(q, y / d);
+                EXPECT_EQ(q, y / big_divisor(d));
+                EXPECT_EQ(y % big_divisor(d), y % d);
+            }
+        }
+    }
+}
+
+TEST(correctness, divexact)
+{
+    EXPECT_EQ(big_integer::divexact(0, 7), 0);
+    EXPECT_EQ(big_integer::divexact(-42, 6), -7);
+    EXPECT_EQ(big_integer::divexact(big_integer(1) << 100, big_integer(1) << 40), big_integer(1) << 60);
+    EXPECT_THROW(big_integer::divexact(5, 0), char const*);
+
+    // a divisor longer than the quotient only counts with as many limbs as the quotient has
+    for (auto const& [d, q] : rand_pairs({{1, 1}, {1, 30}, {3, 3}, {20, 50}, {150, 120}, {150, 700}, {700, 150},
+                                          {1000, 450}, {1000, 1000}}))
+    {
+        for (big_integer const& b : {d, d * 2, d << 77, -(d << 32)})
+        {
+            EXPECT_EQ(big_integer::divexact(b * q, b), q);
+            EXPECT_EQ(big_integer::divexact(-(q * b), b), -q);
+            EXPECT_EQ(big_integer::divexact(b, b), 1);
+        }
+    }
+}
+
+TEST(correctness, power_of_two_division)
+{
+    EXPECT_EQ(big_integer::tdiv_q_2exp(-7, 1), -3);
+    EXPECT_EQ(big_integer::fdiv_q_2exp(-7, 1), -4);
+    EXPECT_EQ(big_integer::mod_2exp(-7, 1), -1);
+    EXPECT_EQ(big_integer::fdiv_q_2exp(-8, 3), -1);
+    EXPECT_EQ(big_integer::mod_2exp(-8, 3), 0);
+    EXPECT_EQ(big_integer(-7) / (1 << 1), -3);
+    EXPECT_EQ(big_integer(-7) % (1 << 1), -1);
+    EXPECT_EQ(big_integer(-1) >> 100, -1);
+
+    for (size_t n : {1, 3, 20})
+    {
+        big_integer x = from_limbs(rand_limbs(n));
+        for (big_integer const& a : {x, -x, x << 64, -(x << 64) - 1})
+        {
+            for (size_t k : {0, 1, 31, 32, 33, 64, 95, 700})
+            {
+                big_integer p = big_integer(1) << static_cast<int>(k);
+                big_integer t = big_integer::tdiv_q_2exp(a, k);
+                big_integer f = big_integer::fdiv_q_2exp(a, k);
+                big_integer r = big_integer::mod_2exp(a, k);
+                EXPECT_EQ(t * p + r, a);
+                EXPECT_LT(r >= 0 ? r : -r, p);
+                EXPECT_TRUE(r == 0 || (r < 0) == (a < 0));
+                EXPECT_EQ(f, r < 0 ? t - 1 : t);
+                EXPECT_EQ(f, a >> static_cast<int>(k));
+
+                check_divmod(a, p);
+                check_divmod(a, -p);
+                check_divmod(a, 3 * p);
+                check_divmod(a, -(x * p));
+            }
+            EXPECT_EQ(a / (uint64_t(1) << 40), big_integer::tdiv_q_2exp(a, 40));
+            EXPECT_EQ(a % (uint64_t(1) << 40), big_integer::mod_2exp(a, 40));
+        }
+    }
+}
+
+TEST(correctness, divisible_by)
+{
+    EXPECT_TRUE(big_integer(0).divisible_by(0));
+    EXPECT_FALSE(big_integer(5).divisible_by(0));
+    EXPECT_TRUE(big_integer(0).divisible_by(big_integer(7)));
+    EXPECT_TRUE(big_integer(-42).divisible_by(-6));
+    EXPECT_FALSE(big_integer(-42).divisible_by(uint64_t(84)));
+    EXPECT_TRUE((big_integer(1) << 100).divisible_by(big_integer(1) << 99));
+    EXPECT_FALSE((big_integer(1) << 99).divisible_by(big_integer(1) << 100));
+
+    // the last two take the quotient off in blocks, one and three of them
+    for (auto const& [x, y] : rand_pairs({{1, 1}, {1, 20}, {2, 3}, {10, 30}, {30, 10}, {60, 200}, {300, 100},
+                                          {1000, 500}, {450, 1000}}))
+    {
+        for (big_integer const& d : {x, x << 1, x << 40, x * 3, -x, x | 1, (x << 64) + 1})
+        {
+            EXPECT_TRUE((d * y).divisible_by(d));
+            EXPECT_TRUE((-(d * y)).divisible_by(d));
+            EXPECT_EQ((d * y + 1).divisible_by(d), d == 1 || d == -1);
+            EXPECT_EQ((d * y + (d >> 1)).divisible_by(d), (d >> 1) % d == 0);
+            EXPECT_EQ(y.divisible_by(d), y % d == 0);
+            EXPECT_FALSE((d * y).divisible_by(d * y + 1));
+        }
+        uint32_t small = static_cast<uint32_t>(rand_limbs(1)[0]) | 1;
+        EXPECT_TRUE((y * small).divisible_by(small));
+        EXPECT_EQ(y.divisible_by(small), y % small == 0);
+    }
+}
+
+TEST(correctness, floor_ceil_euclid)
+{
+    EXPECT_EQ(big_integer::fdiv_qr(-7, 2), std::make_pair(big_integer(-4), big_integer(1)));
+    EXPECT_EQ(big_integer::fdiv_qr(7, -2), std::make_pair(big_integer(-4), big_integer(-1)));
+    EXPECT_EQ(big_integer::cdiv_qr(7, 2), std::make_pair(big_integer(4), big_integer(-1)));
+    EXPECT_EQ(big_integer::cdiv_qr(-7, -2), std::make_pair(big_integer(4), big_integer(1)));
+    EXPECT_EQ(big_integer::ediv_qr(-7, 2), std::make_pair(big_integer(-4), big_integer(1)));
+    EXPECT_EQ(big_integer::ediv_qr(-7, -2), std::make_pair(big_integer(4), big_integer(1)));
+    EXPECT_EQ(big_integer::fdiv_qr(-1, 5), std::make_pair(big_integer(-1), big_integer(4)));
+    EXPECT_EQ(big_integer::cdiv_qr(-6, 3), std::make_pair(big_integer(-2), big_integer(0)));
+
+    for (auto const& [x, y] : rand_pairs({{1, 1}, {3, 1}, {5, 2}, {20, 3}, {100, 50}, {300, 100}}))
+    {
+        for (big_integer const& a : {x, -x, x - x % y, (x - x % y) + 1, -(x - x % y) - 1})
+            for (big_integer const& b : {y, -y, y << 32, -(y << 1)})
+            {
+                auto f = big_integer::fdiv_qr(a, b);
+                auto c = big_integer::cdiv_qr(a, b);
+                auto e = big_integer::ediv_qr(a, b);
+                EXPECT_EQ(f.first * b + f.second, a);
+                EXPECT_EQ(c.first * b + c.second, a);
+                EXPECT_EQ(e.first * b + e.second, a);
+                EXPECT_TRUE(f.second == 0 || (f.second < 0) == (b < 0));
+                EXPECT_TRUE(c.second == 0 || (c.second < 0) != (b < 0));
+                EXPECT_TRUE(e.second >= 0);
+                big_integer mb = b < 0 ? -b : b;
+                EXPECT_TRUE(f.second < mb && -f.second < mb);
+                EXPECT_TRUE(c.second < mb && -c.second < mb);
+                EXPECT_TRUE(e.second < mb);
+            }
+    }
+}
+
+TEST(correctness, long_string_conv)
+{
+    for (size_t digits : {300, 2000, 9000})
+    {
+        std::string ones = "1" + std::string(digits, '0');
+        std::string nines(digits, '9');
+        EXPECT_EQ(to_string(big_integer(ones)), ones);
+        EXPECT_EQ(to_string(big_integer(nines)), nines);
+        EXPECT_EQ(to_string(-big_integer(ones)), "-" + ones);
+        EXPECT_EQ(to_string(big_integer(ones) + 7), std::string(ones, 0, digits) + "7");
+    }
+
+    for (size_t n : {31, 64, 100, 500, 2000})
+    {
+        big_integer x = from_limbs(rand_limbs(n));
+        std::string s = to_string(x);
+        EXPECT_EQ(big_integer(s), x);
+        EXPECT_EQ(to_string(-x), "-" + s);
+        big_integer p = big_integer(std::string("1" + std::string(1000, '0')));
+        EXPECT_EQ(to_string(x * p), s + std::string(1000, '0'));
+    }
+}
+
+TEST(correctness, long_string_parsing)
+{
+    auto digits = [](size_t len) {
+        std::string s;
+        for (size_t i = 0; i < len; i++)
+            s += static_cast<char>('0' + rand() % 10);
+        return s;
+    };
+    for (size_t len : {8, 9, 10, 999, 1000, 1001, 4000})
+    {
+        std::string hi = digits(len), lo = digits(len / 3 + 1);
+        big_integer ten = 1;
+        for (size_t i = 0; i < lo.size(); i++)
+            ten *= 10;
+        EXPECT_EQ(big_integer(hi + lo), big_integer(hi) * ten + big_integer(lo));
+        EXPECT_EQ(big_integer(std::string(2000, '0') + hi), big_integer(hi));
+        EXPECT_EQ(big_integer("-" + hi + lo), -(big_integer(hi) * ten + big_integer(lo)));
+        EXPECT_EQ(to_string(big_integer("1" + hi)), "1" + hi);
+    }
+    EXPECT_EQ(big_integer(std::string(5000, '0')), 0);
+    EXPECT_EQ(big_integer("-" + std::string(5000, '0')), 0);
+}
+
+TEST(correctness, radix_conv)
+{
+    EXPECT_EQ(to_string(big_integer(255), 16), "ff");
+    EXPECT_EQ(to_string(big_integer(-255), 2), "-11111111");
+    EXPECT_EQ(to_string(big_integer(0), 7), "0");
+    EXPECT_EQ(to_string(big_integer(1295), 36), "zz");
+    EXPECT_EQ(to_string(big_integer(1) << 100, 16), "1" + std::string(25, '0'));
+    EXPECT_EQ(to_string(big_integer(1) << 100, 8), "2" + std::string(33, '0'));
+    EXPECT_EQ(to_string(big_integer(1) << 100, 32), "1" + std::string(20, '0'));
+    EXPECT_EQ(big_integer("FF", 16), 255);
+    EXPECT_EQ(big_integer("-zZ", 36), -1295);
+    EXPECT_EQ(big_integer("-000", 2), 0);
+    EXPECT_EQ(big_integer("1" + std::string(40, '0'), 4), big_integer(1) << 80);
+    EXPECT_EQ(big_integer("ffffffffffffffffffffffff", 16), (big_integer(1) << 96) - 1);
+
+    for (size_t n : {1, 2, 40, 300})
+    {
+        big_integer x = from_limbs(rand_limbs(n));
+        for (int base = 2; base <= 36; base++)
+        {
+            std::string s = to_string(x, base);
+            EXPECT_EQ(big_integer(s, base), x);
+            EXPECT_EQ(to_string(-x, base), "-" + s);
+            EXPECT_EQ(big_integer("-" + s, base), -x);
+        }
+        EXPECT_EQ(to_string(x, 10), to_string(x));
+    }
+}
+
+TEST(correctness, to_from_chars)
+{
+    char buf[64];
+    big_integer x(-255);
+    auto tr = to_chars(buf, buf + sizeof buf, x, 16);
+    EXPECT_EQ(tr.ec, std::errc());
+    EXPECT_EQ(std::string(buf, tr.ptr), "-ff");
+    EXPECT_EQ(to_chars(buf, buf + 3, x, 16).ec, std::errc());
+    EXPECT_EQ(to_chars(buf, buf + 2, x, 16).ec, std::errc::value_too_large);
+    EXPECT_EQ(to_chars(buf, buf, big_integer(0)).ec, std::errc::value_too_large);
+    EXPECT_EQ(to_chars(buf, buf + sizeof buf, x, 37).ec, std::errc::invalid_argument);
+    EXPECT_THROW(digits_upper_bound(x, 1), char const*);
+    EXPECT_THROW(digits_upper_bound(x, 0), char const*);
+    EXPECT_THROW(digits_upper_bound(big_integer(0), 37), char const*);
+
+    big_integer y(7);
+    auto fr = from_chars("12x", "12x" + 3, y);
+    EXPECT_EQ(fr.ec, std::errc());
+    EXPECT_EQ(*fr.ptr, 'x');
+    EXPECT_EQ(y, 12);
+    // the characters on either side of '0'-'9', 'A'-'Z' and 'a'-'z' are not digits
+    for (int base : {10, 16, 36})
+    {
+        for (char c : {'/', ':', '@', '[', '`', '{'})
+        {
+            std::string str = std::string("1") + c;
+            fr = from_chars(str.data(), str.data() + str.size(), y, base);
+            EXPECT_EQ(fr.ec, std::errc());
+            EXPECT_EQ(fr.ptr, str.data() + 1);
+            EXPECT_EQ(y, 1);
+        }
+    }
+    y = 12;
+    char const *bad[] = {"", "-", "+5", " 5", "x"};
+    for (char const *s : bad)
+    {
+        std::string str(s);
+        fr = from_chars(str.data(), str.data() + str.size(), y);
+        EXPECT_EQ(fr.ec, std::errc::invalid_argument);
+        EXPECT_EQ(fr.ptr, str.data());
+        EXPECT_EQ(y, 12);
+    }
+    std::string hex = "-fFg";
+    fr = from_chars(hex.data(), hex.data() + hex.size(), y, 16);
+    EXPECT_EQ(fr.ptr, hex.data() + 3);
+    EXPECT_EQ(y, -255);
+    std::string zero = "-0";
+    from_chars(zero.data(), zero.data() + zero.size(), y);
+    EXPECT_EQ(y, 0);
+    EXPECT_EQ(to_string(y), "0");
+
+    for (size_t n : {1, 3, 40, 300})
+    {
+        big_integer z = -from_limbs(rand_limbs(n));
+        for (int base : {2, 3, 8, 10, 16, 36})
+        {
+            std::string s = to_string(z, base);
+            size_t bound = digits_upper_bound(z, base);
+            EXPECT_GE(bound, s.size());
+            EXPECT_LE(bound, s.size() + 2);
+            std::vector<char> out(s.size());
+            tr = to_chars(out.data(), out.data() + out.size(), z, base);
+            EXPECT_EQ(tr.ec, std::errc());
+            EXPECT_EQ(std::string(out.data(), tr.ptr), s);
+            EXPECT_EQ(to_chars(out.data(), out.data() + out.size() - 1, z, base).ec, std::errc::value_too_large);
+
+            big_integer w;
+            fr = from_chars(s.data(), s.data() + s.size(), w, base);
+            EXPECT_EQ(fr.ec, std::errc());
+            EXPECT_EQ(fr.ptr, s.data() + s.size());
+            EXPECT_EQ(w, z);
+        }
+    }
+}
+
+TEST(correctness, stream_io)
+{
+    for (size_t n : {1, 50, 2000})
+    {
+        big_integer x = from_limbs(rand_limbs(n));
+        for (big_integer const& y : {x, -x})
+        {
+            std::ostringstream out;
+            out << y << ' ' << big_integer(0);
+            EXPECT_EQ(out.str(), to_string(y) + " 0");
+
+            std::istringstream in(" " + out.str() + "x");
+            big_integer z, w;
+            in >> z >> w;
+            EXPECT_EQ(z, y);
+            EXPECT_EQ(w, 0);
+            EXPECT_EQ(in.peek(), 'x');
+        }
+    }
+
+    std::ostringstream padded;
+    padded << std::setw(6) << big_integer(-42);
+    EXPECT_EQ(padded.str(), "   -42");
+
+    // whole blocks of digits, and one digit more or less
+    for (size_t len : {1151, 1152, 1153, 3 * 1152, 4 * 1152, 4 * 1152 + 7})
+    {
+        std::string s;
+        for (size_t i = 0; i < len; i++)
+            s += static_cast<char>('0' + (i == 0 ? 1 + rand() % 9 : rand() % 10));
+        std::istringstream in(s);
+        big_integer z;
+        in >> z;
+        EXPECT_EQ(z, big_integer(s));
+        EXPECT_TRUE(in.eof());
+        EXPECT_FALSE(in.fail());
+    }
+
+    for (char const *bad : {"abc", "-", "- 1", ""})
+    {
+        std::istringstream in(bad);
+        big_integer z(5);
+        in >> z;
+        EXPECT_TRUE(in.fail());
+        EXPECT_EQ(z, 5);
+    }
+}
@@ -0,0 +1,1174 @@
+#include "limbs.h"
+#include "limbs_x86.h"
+#include <algorithm>
+#include <vector>
+
+namespace limbs {
+
+ui const SHIFT = 32;
+
+static ui add_n_scalar(ui *r, ui const *a, ui const *b, size_t n) {
+    ull carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (ull) a[i] + b[i];
+        r[i] = static_cast<ui>(carry);
+        carry >>= SHIFT;
+    }
+    return static_cast<ui>(carry);
+}
+
+static ui sub_n_scalar(ui *r, ui const *a, ui const *b, size_t n) {
+    ui borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        ull diff = (ull) a[i] - b[i] - borrow;
+        r[i] = static_cast<ui>(diff);
+        borrow = static_cast<ui>(diff >> 63);
+    }
+    return borrow;
+}
+
+ui add(ui *r, ui const *a, size_t an, ui const *b, size_t bn) {
+    ui carry = add_n(r, a, b, bn);
+    return add_1(r + bn, a + bn, an - bn, carry);
+}
+
+ui sub(ui *r, ui const *a, size_t an, ui const *b, size_t bn) {
+    ui borrow = sub_n(r, a, b, bn);
+    return sub_1(r + bn, a + bn, an - bn, borrow);
+}
+
+// in place, the carry usually dies out after a limb or two and the rest is left as is
+ui add_1(ui *r, ui const *a, size_t n, ui b) {
+    ull carry = b;
+    for (size_t i = 0; i < n && (carry != 0 || r != a); i++) {
+        carry += a[i];
+        r[i] = static_cast<ui>(carry);
+        carry >>= SHIFT;
+    }
+    return static_cast<ui>(carry);
+}
+
+ui sub_1(ui *r, ui const *a, size_t n, ui b) {
+    ui borrow = b;
+    for (size_t i = 0; i < n && (borrow != 0 || r != a); i++) {
+        ull diff = (ull) a[i] - borrow;
+        r[i] = static_cast<ui>(diff);
+        borrow = static_cast<ui>(diff >> 63);
+    }
+    return borrow;
+}
+
+int cmp(ui const *a, ui const *b, size_t n) {
+    for (size_t i = n; i-- != 0;) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+ui mul_1(ui *r, ui const *a, size_t n, ui b) {
+    ull carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (ull) a[i] * b;
+        r[i] = static_cast<ui>(carry);
+        carry >>= SHIFT;
+    }
+    return static_cast<ui>(carry);
+}
+
+ui addmul_1(ui *r, ui const *a, size_t n, ui b) {
+    ull carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (ull) a[i] * b + r[i];
+        r[i] = static_cast<ui>(carry);
+        carry >>= SHIFT;
+    }
+    return static_cast<ui>(carry);
+}
+
+ui submul_1(ui *r, ui const *a, size_t n, ui b) {
+    ull borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        ull prod = (ull) a[i] * b + borrow;
+        ui low = static_cast<ui>(prod);
+        borrow = (prod >> SHIFT) + (r[i] < low);
+        r[i] -= low;
+    }
+    return static_cast<ui>(borrow);
+}
+
+ui rshift(ui *r, ui const *a, size_t n, unsigned cnt) {
+    ui out = a[0] << (SHIFT - cnt);
+    for (size_t i = 0; i + 1 < n; i++)
+        r[i] = (a[i] >> cnt) | (a[i + 1] << (SHIFT - cnt));
+    r[n - 1] = a[n - 1] >> cnt;
+    return out;
+}
+
+ui lshift(ui *r, ui const *a, size_t n, unsigned cnt) {
+    ui out = a[n - 1] >> (SHIFT - cnt);
+    for (size_t i = n - 1; i > 0; i--)
+        r[i] = (a[i] << cnt) | (a[i - 1] >> (SHIFT - cnt));
+    r[0] = a[0] << cnt;
+    return out;
+}
+
+ui invert_limb(ui d) {
+    return static_cast<ui>(~((ull) d << SHIFT) / d);
+}
+
+// (n1 n0) / d for d with the top bit set and n1 < d, with v = invert_limb(d): Moller and
+// Granlund, algorithm 4. The remainder goes to r
+static inline ui div_2by1(ui &r, ui n1, ui n0, ui d, ui v) {
+    ull q = (ull) v * n1 + (((ull) n1 << SHIFT) | n0);
+    ui q1 = static_cast<ui>(q >> SHIFT) + 1;
+    ui q0 = static_cast<ui>(q);
+    r = n0 - q1 * d;
+    if (r > q0) {
+        q1--;
+        r += d;
+    }
+    if (r >= d) {
+        q1++;
+        r -= d;
+    }
+    return q1;
+}
+
+static unsigned normalization(ui d) {
+    unsigned shift = 0;
+    for (; !(d >> (SHIFT - 1)); d <<= 1)
+        shift++;
+    return shift;
+}
+
+ui divrem_1(ui *q, ui const *a, size_t n, ui d) {
+    unsigned shift = normalization(d);
+    return divrem_1(q, a, n, d << shift, shift, invert_limb(d << shift));
+}
+
+// the dividend is shifted along with the divisor as it is read, a limb at a time
+ui divrem_1(ui *q, ui const *a, size_t n, ui d, unsigned shift, ui dinv) {
+    ui r = 0;
+    if (shift == 0) {
+        for (size_t i = n; i-- != 0;)
+            q[i] = div_2by1(r, r, a[i], d, dinv);
+        return r;
+    }
+    r = a[n - 1] >> (SHIFT - shift);
+    for (size_t i = n; i-- != 0;) {
+        ui n0 = (a[i] << shift) | (i ? a[i - 1] >> (SHIFT - shift) : 0);
+        q[i] = div_2by1(r, r, n0, d, dinv);
+    }
+    return r >> shift;
+}
+
+ui mod_1(ui const *a, size_t n, ui d) {
+    unsigned shift = normalization(d);
+    ui dn = d << shift;
+    ui dinv = invert_limb(dn);
+    ui r = 0;
+    if (shift == 0) {
+        for (size_t i = n; i-- != 0;)
+            div_2by1(r, r, a[i], dn, dinv);
+        return r;
+    }
+    r = a[n - 1] >> (SHIFT - shift);
+    for (size_t i = n; i-- != 0;)
+        div_2by1(r, r, (a[i] << shift) | (i ? a[i - 1] >> (SHIFT - shift) : 0), dn, dinv);
+    return r >> shift;
+}
+
+// Moller and Granlund, "Improved division by invariant integers", algorithm 6: the
+// reciprocal of d1 alone is adjusted for d0
+ui invert_3by2(ui d1, ui d0) {
+    ui v = invert_limb(d1);
+    ui p = d1 * v + d0;
+    if (p < d0) {
+        v--;
+        if (p >= d1) {
+            v--;
+            p -= d1;
+        }
+        p -= d1;
+    }
+    ull t = (ull) d0 * v;
+    ui t1 = static_cast<ui>(t >> SHIFT);
+    ui t0 = static_cast<ui>(t);
+    p += t1;
+    if (p < t1) {
+        v--;
+        if (p > d1 || (p == d1 && t0 >= d0))
+            v--;
+    }
+    return v;
+}
+
+// (n2 n1 n0) / (d1 d0) for (n2 n1) < (d1 d0), with v = invert_3by2(d1, d0): one product
+// gives the quotient up to two corrections
+static inline ui div_3by2(ui n2, ui n1, ui n0, ui d1, ui d0, ui v) {
+    ull q = (ull) v * n2 + (((ull) n2 << SHIFT) | n1);
+    ui q1 = static_cast<ui>(q >> SHIFT);
+    ui q0 = static_cast<ui>(q);
+    ull d = ((ull) d1 << SHIFT) | d0;
+    ui r1 = n1 - q1 * d1;
+    ull r = (((ull) r1 << SHIFT) | n0) - d - (ull) d0 * q1;
+    q1++;
+    if (static_cast<ui>(r >> SHIFT) >= q0) {
+        q1--;
+        r += d;
+    }
+    if (r >= d)
+        q1++;
+    return q1;
+}
+
+static ui div_qr_basecase(ui *q, ui *a, size_t an, ui const *d, size_t dn, ui dinv) {
+    ui qh = cmp(a + an - dn, d, dn) >= 0;
+    if (qh)
+        sub_n(a + an - dn, a + an - dn, d, dn);
+
+    ui d1 = d[dn - 1];
+    ui d0 = d[dn - 2];
+    for (size_t i = an - dn; i-- > 0;) {
+        // the window a[i, i + dn] is below d * B, so its top two limbs are at most d1 d0;
+        // the estimate from the top three limbs is at most one too large
+        ui *w = a + i;
+        ui qhat = w[dn] == d1 && w[dn - 1] == d0 ? UINT32_MAX : div_3by2(w[dn], w[dn - 1], w[dn - 2], d1, d0, dinv);
+
+        ui borrow = submul_1(w, d, dn, qhat);
+        if (w[dn] < borrow) {
+            qhat--;
+            add_n(w, w, d, dn);
+        }
+        w[dn] = 0;
+        q[i] = qhat;
+    }
+    return qh;
+}
+
+// 2n limbs of a by the n limbs of d, as div_qr: the high half of the quotient comes from
+// the top limbs of a and d alone, then the low half of d times that quotient is taken off
+// what is left, and the same again one level down for the low half of the quotient.
+// ws has room for n limbs
+static ui div_qr_n(ui *q, ui *a, ui const *d, size_t n, ui dinv, ui *ws) {
+    size_t lo = n / 2;
+    size_t hi = n - lo;
+
+    ui qh = hi < DC_DIV_THRESHOLD ? div_qr_basecase(q + lo, a + 2 * lo, 2 * hi, d + lo, hi, dinv)
+                                  : div_qr_n(q + lo, a + 2 * lo, d + lo, hi, dinv, ws);
+    mul(ws, q + lo, hi, d, lo);
+    ui cy = sub_n(a + lo, a + lo, ws, n);
+    if (qh)
+        cy += sub_n(a + n, a + n, d, lo);
+    // each round adds d back once; the estimate is off by a few at most
+    while (cy) {
+        qh -= sub_1(q + lo, q + lo, hi, 1);
+        cy -= add_n(a + lo, a + lo, d, n);
+    }
+
+    ui ql = lo < DC_DIV_THRESHOLD ? div_qr_basecase(q, a + hi, 2 * lo, d + hi, lo, dinv)
+                                  : div_qr_n(q, a + hi, d + hi, lo, dinv, ws);
+    mul(ws, d, hi, q, lo);
+    cy = sub_n(a, a, ws, n);
+    if (ql)
+        cy += sub_n(a + lo, a + lo, d, hi);
+    while (cy) {
+        sub_1(q, q, lo, 1);
+        cy -= add_n(a, a, d, n);
+    }
+    return qh;
+}
+
+// qn + dn limbs of a by the dn limbs of d for qn <= dn: the top 2 qn limbs are divided by
+// the top qn limbs of d, the rest of d is taken off afterwards
+static ui div_qr_block(ui *q, ui *a, size_t qn, ui const *d, size_t dn, ui dinv, ui *ws) {
+    if (qn < DC_DIV_THRESHOLD)
+        return div_qr_basecase(q, a, qn + dn, d, dn, dinv);
+
+    ui qh = div_qr_n(q, a + dn - qn, d + dn - qn, qn, dinv, ws);
+    if (qn != dn) {
+        mul(ws, q, qn, d, dn - qn);
+        ui cy = sub_n(a, a, ws, dn);
+        if (qh)
+            cy += sub_n(a + qn, a + qn, d, dn - qn);
+        while (cy) {
+            qh -= sub_1(q, q, qn, 1);
+            cy -= add_n(a, a, d, dn);
+        }
+    }
+    return qh;
+}
+
+ui div_qr(ui *q, ui *a, size_t an, ui const *d, size_t dn) {
+    return div_qr(q, a, an, d, dn, invert_3by2(d[dn - 1], d[dn - 2]));
+}
+
+ui div_qr(ui *q, ui *a, size_t an, ui const *d, size_t dn, ui dinv) {
+    size_t qn = an - dn;
+    if (dn < DC_DIV_THRESHOLD || qn < DC_DIV_THRESHOLD)
+        return div_qr_basecase(q, a, an, d, dn, dinv);
+
+    // a first block of up to dn quotient limbs, then whole blocks of dn limbs
+    std::vector<ui> ws(dn);
+    size_t first = (qn - 1) % dn + 1;
+    size_t off = qn - first;
+    ui qh = div_qr_block(q + off, a + off, first, d, dn, dinv, ws.data());
+    while (off > 0) {
+        off -= dn;
+        div_qr_n(q + off, a + off, d, dn, dinv, ws.data());
+    }
+    return qh;
+}
+
+// inverse of odd d modulo B
+static ui binvert_limb(ui d) {
+    ui inv = d;
+    for (int i = 0; i < 5; i++)
+        inv *= 2 - d * inv;
+    return inv;
+}
+
+void divexact_1(ui *r, ui const *a, size_t n, ui d) {
+    ui inv = binvert_limb(d);
+    ui borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        ull diff = (ull) a[i] - borrow;
+        ui q = static_cast<ui>(diff) * inv;
+        r[i] = q;
+        borrow = static_cast<ui>(((ull) q * d) >> SHIFT) + static_cast<ui>(diff >> 63);
+    }
+}
+
+// one row per limb of b, the carry of each row stays in a register
+static void mul_basecase_scalar(ui *r, ui const *a, size_t an, ui const *b, size_t bn) {
+    r[an] = mul_1(r, a, an, b[0]);
+    for (size_t j = 1; j < bn; j++)
+        r[an + j] = addmul_1(r + j, a, an, b[j]);
+}
+
+// The kernels in use. They start out scalar, so that calls made before the CPU is
+// examined (from other static initializers) still work.
+static struct {
+    ui (*add_n)(ui *, ui const *, ui const *, size_t);
+    ui (*sub_n)(ui *, ui const *, ui const *, size_t);
+    void (*mul_basecase)(ui *, ui const *, size_t, ui const *, size_t);
+} kernels = {add_n_scalar, sub_n_scalar, mul_basecase_scalar};
+
+static isa active = isa::scalar;
+
+isa best_isa() {
+#if BIGINT_X86_KERNELS
+    // the kernels are picked by a static initializer, which may run before libgcc has
+    // filled in what the CPU supports
+    __builtin_cpu_init();
+    if (x86::has_avx512())
+        return isa::avx512;
+    if (x86::has_avx2())
+        return isa::avx2;
+#endif
+    return isa::scalar;
+}
+
+isa set_isa(isa requested) {
+    active = std::min(requested, best_isa());
+    kernels = {add_n_scalar, sub_n_scalar, mul_basecase_scalar};
+#if BIGINT_X86_KERNELS
+    if (active == isa::avx2)
+        kernels = {x86::add_n_avx2, x86::sub_n_avx2, x86::mul_basecase_avx2};
+    if (active == isa::avx512)
+        kernels = {x86::add_n_avx512, x86::sub_n_avx512, x86::mul_basecase_avx512};
+#endif
+    return active;
+}
+
+static isa const selected = set_isa(isa::avx512);
+
+ui add_n(ui *r, ui const *a, ui const *b, size_t n) {
+    return kernels.add_n(r, a, b, n);
+}
+
+ui sub_n(ui *r, ui const *a, ui const *b, size_t n) {
+    return kernels.sub_n(r, a, b, n);
+}
+
+void mul_basecase(ui *r, ui const *a, size_t an, ui const *b, size_t bn) {
+    if (an < bn) {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+    // the vector kernels win from a few rows on
+    if (active == isa::scalar || bn < SIMD_MUL_MIN_BN || bn > SIMD_MUL_MAX_BN)
+        mul_basecase_scalar(r, a, an, b, bn);
+    else
+        kernels.mul_basecase(r, a, an, b, bn);
+}
+
+void sqr_basecase(ui *r, ui const *a, size_t n) {
+    // up to SIMD_MUL_MAX_BN limbs the vector basecase, doing all n^2 products, beats the
+    // halved scalar loop
+    if (active != isa::scalar && n >= SIMD_MUL_MIN_BN && n <= SIMD_MUL_MAX_BN) {
+        kernels.mul_basecase(r, a, n, a, n);
+        return;
+    }
+
+    // products a_i a_j for i < j, doubled, plus the squares on the diagonal
+    r[0] = 0;
+    r[2 * n - 1] = 0;
+    if (n > 1) {
+        r[n] = mul_1(r + 1, a + 1, n - 1, a[0]);
+        for (size_t i = 1; i + 1 < n; i++)
+            r[n + i] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+        lshift(r, r, 2 * n, 1);
+    }
+
+    ull carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        ull sq = (ull) a[i] * a[i];
+        carry += (ull) r[2 * i] + (sq & UINT32_MAX);
+        r[2 * i] = static_cast<ui>(carry);
+        carry = (carry >> SHIFT) + r[2 * i + 1] + (sq >> SHIFT);
+        r[2 * i + 1] = static_cast<ui>(carry);
+        carry >>= SHIFT;
+    }
+}
+
+// scratch limbs needed by mul_rec for operands of at most n limbs; every tier
+// takes no more than 4n + 40 limbs for itself and recurses on at most n / 2 + 2 limbs
+static size_t mul_itch(size_t n) {
+    if (n < KARATSUBA_THRESHOLD)
+        return 0;
+    return 4 * n + 40 + mul_itch(n / 2 + 2);
+}
+
+static void mul_rec(ui *r, ui const *a, size_t an, ui const *b, size_t bn, ui *ws);
+
+// The halved scalar loop only pays off against scalar products: past SIMD_MUL_MAX_BN it is
+// slower than Karatsuba with vector leaves, so squares then switch where products do.
+static size_t sqr_karatsuba_threshold() {
+    return active == isa::scalar ? SQR_KARATSUBA_THRESHOLD : KARATSUBA_THRESHOLD;
+}
+
+// Every tier squares when a and b are the same operand: b is then neither evaluated
+// nor split, and all the recursive products are squares as well.
+static bool is_square(ui const *a, size_t an, ui const *b, size_t bn) {
+    return a == b && an == bn;
+}
+
+// a = a1 * B^m + a0, b = b1 * B^m + b0, requires an >= bn > m
+static void karatsuba(ui *r, ui const *a, size_t an, ui const *b, size_t bn, ui *ws) {
+    size_t m = (an + 1) / 2;
+    size_t h = an - m;
+    size_t k = bn - m;
+
+    mul_rec(r, a, m, b, m, ws);
+    mul_rec(r + 2 * m, a + m, h, b + m, k, ws);
+
+    ui *s = ws;
+    ui *t = ws + m + 1;
+    ui *p = ws + 2 * m + 2;
+    s[m] = add(s, a, m, a + m, h);
+    if (is_square(a, an, b, bn))
+        t = s;
+    else
+        t[m] = add(t, b, m, b + m, k);
+    mul_rec(p, s, m + 1, t, m + 1, ws + 4 * m + 4);
+
+    // p = (a0 + a1)(b0 + b1) - a0 b0 - a1 b1 = a0 b1 + a1 b0
+    sub(p, p, 2 * m + 2, r, 2 * m);
+    sub(p, p, 2 * m + 2, r + 2 * m, h + k);
+
+    size_t len = an + bn - m;
+    add(r + m, r + m, len, p, std::min(len, 2 * m + 2));
+}
+
+// a is cut into chunks of bn limbs, and each chunk is multiplied by b as a balanced product
+static void mul_unbalanced(ui *r, ui const *a, size_t an, ui const *b, size_t bn, ui *ws) {
+    ui *t = ws;
+    ui *next = ws + 2 * bn;
+
+    mul_rec(r, a, bn, b, bn, next);
+    for (size_t done = bn; done < an;) {
+        // r holds the product of the first done limbs of a
+        size_t len = std::min(bn, an - done);
+        mul_rec(t, a + done, len, b, bn, next);
+        ui carry = add_n(r + done, r + done, t, bn);
+        add_1(r + done + bn, t + bn, len, carry);
+        done += len;
+    }
+}
+
+// Toom-Cook: a and b are cut into k pieces of m limbs (the last ones may be shorter),
+// the pieces are evaluated as polynomials at 2k - 1 points, the values are multiplied
+// and the product coefficients are interpolated back. Interpolation works modulo
+// B^(2m + 2) in place: the evaluated products can be negative, but every value
+// that is shifted or divided there is a non-negative combination of coefficients.
+
+// r[0..m] = sum of coeff[i] * a_i
+static void eval_sum(ui *r, ui const *a, size_t an, size_t m, size_t k, ui const *coeff) {
+    std::fill(r, r + m + 1, 0);
+    for (size_t i = 0; i < k; i++) {
+        if (coeff[i] == 0)
+            continue;
+        size_t len = std::min(m, an - i * m);
+        ui carry = addmul_1(r, a + i * m, len, coeff[i]);
+        add_1(r + len, r + len, m + 1 - len, carry);
+    }
+}
+
+// rp = even + odd, rm = |even - odd|; returns whether even - odd is negative
+static bool eval_pm(ui *rp, ui *rm, ui *even, ui *odd, ui const *a, size_t an, size_t m, size_t k,
+                    ui const *ce, ui const *co) {
+    eval_sum(even, a, an, m, k, ce);
+    eval_sum(odd, a, an, m, k, co);
+    add_n(rp, even, odd, m + 1);
+    if (cmp(even, odd, m + 1) >= 0) {
+        sub_n(rm, even, odd, m + 1);
+        return false;
+    }
+    sub_n(rm, odd, even, m + 1);
+    return true;
+}
+
+static void neg_wrap(ui *r, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        r[i] = ~r[i];
+    add_1(r, r, n, 1);
+}
+
+static void submul_wrap(ui *r, size_t rn, ui const *a, size_t an, ui b) {
+    ui borrow = submul_1(r, a, an, b);
+    sub_1(r + an, r + an, rn - an, borrow);
+}
+
+// adds the interpolated coefficients c_1 .. c_(count) to r at multiples of m
+static void toom_add_coeffs(ui *r, size_t rn, size_t m, size_t w, ui *const *coeffs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        size_t len = rn - (i + 1) * m;
+        add(r + (i + 1) * m, r + (i + 1) * m, len, coeffs[i], std::min(len, w));
+    }
+}
+
+// requires an >= bn > 2m for m = ceil(an / 3); points 0, 1, -1, 2, inf
+static void toom3(ui *r, ui const *a, size_t an, ui const *b, size_t bn, ui *ws) {
+    static ui const even[] = {1, 0, 1}, odd[] = {0, 1, 0}, two[] = {1, 2, 4};
+
+    size_t m = (an + 2) / 3;
+    size_t ct = an + bn - 4 * m;
+    size_t w = 2 * m + 2;
+    ui *v1 = ws, *vm1 = v1 + w, *v2 = vm1 + w;
+    ui *ap = v2 + w, *am = ap + m + 1, *bp = am + m + 1, *bm = bp + m + 1;
+    ui *x = bm + m + 1, *y = x + m + 1;
+    ui *next = y + m + 1;
+
+    bool square = is_square(a, an, b, bn);
+    if (square) {
+        bp = ap;
+        bm = am;
+    }
+
+    bool neg = eval_pm(ap, am, x, y, a, an, m, 3, even, odd);
+    if (!square)
+        neg ^= eval_pm(bp, bm, x, y, b, bn, m, 3, even, odd);
+    mul_rec(v1, ap, m + 1, bp, m + 1, next);
+    mul_rec(vm1, am, m + 1, bm, m + 1, next);
+    if (neg && !square)
+        neg_wrap(vm1, w);
+
+    eval_sum(ap, a, an, m, 3, two);
+    if (!square)
+        eval_sum(bp, b, bn, m, 3, two);
+    mul_rec(v2, ap, m + 1, bp, m + 1, next);
+
+    ui *c0 = r, *c4 = r + 4 * m;
+    mul_rec(c0, a, m, b, m, next);
+    mul_rec(c4, a + 2 * m, an - 2 * m, b + 2 * m, bn - 2 * m, next);
+    std::fill(r + 2 * m, r + 4 * m, 0);
+
+    sub_n(v1, v1, vm1, w);              // 2 (c1 + c3)
+    rshift(v1, v1, w, 1);
+    add_n(vm1, vm1, v1, w);             // c0 + c2 + c4
+    sub(vm1, vm1, w, c0, 2 * m);
+    sub(vm1, vm1, w, c4, ct);           // c2
+
+    sub(v2, v2, w, c0, 2 * m);
+    submul_1(v2, vm1, w, 4);
+    submul_wrap(v2, w, c4, ct, 16);     // 2 (c1 + 4 c3)
+    rshift(v2, v2, w, 1);
+    sub_n(v2, v2, v1, w);               // 3 c3
+    divexact_1(v2, v2, w, 3);
+    sub_n(v1, v1, v2, w);               // c1
+
+    ui *coeffs[] = {v1, vm1, v2};
+    toom_add_coeffs(r, an + bn, m, w, coeffs, 3);
+}
+
+// requires an >= bn > 3m for m = ceil(an / 4); points 0, 1, -1, 2, -2, 3, inf
+static void toom4(ui *r, ui const *a, size_t an, ui const *b, size_t bn, ui *ws) {
+    static ui const even1[] = {1, 0, 1, 0}, odd1[] = {0, 1, 0, 1};
+    static ui const even2[] = {1, 0, 4, 0}, odd2[] = {0, 2, 0, 8};
+    static ui const three[] = {1, 3, 9, 27};
+
+    size_t m = (an + 3) / 4;
+    size_t ct = an + bn - 6 * m;
+    size_t w = 2 * m + 2;
+    ui *v1 = ws, *vm1 = v1 + w, *v2 = vm1 + w, *vm2 = v2 + w, *v3 = vm2 + w;
+    ui *ap = v3 + w, *am = ap + m + 1, *bp = am + m + 1, *bm = bp + m + 1;
+    ui *x = bm + m + 1, *y = x + m + 1;
+    ui *next = y + m + 1;
+
+    bool square = is_square(a, an, b, bn);
+    if (square) {
+        bp = ap;
+        bm = am;
+    }
+
+    bool neg = eval_pm(ap, am, x, y, a, an, m, 4, even1, odd1);
+    if (!square)
+        neg ^= eval_pm(bp, bm, x, y, b, bn, m, 4, even1, odd1);
+    mul_rec(v1, ap, m + 1, bp, m + 1, next);
+    mul_rec(vm1, am, m + 1, bm, m + 1, next);
+    if (neg && !square)
+        neg_wrap(vm1, w);
+
+    neg = eval_pm(ap, am, x, y, a, an, m, 4, even2, odd2);
+    if (!square)
+        neg ^= eval_pm(bp, bm, x, y, b, bn, m, 4, even2, odd2);
+    mul_rec(v2, ap, m + 1, bp, m + 1, next);
+    mul_rec(vm2, am, m + 1, bm, m + 1, next);
+    if (neg && !square)
+        neg_wrap(vm2, w);
+
+    eval_sum(ap, a, an, m, 4, three);
+    if (!square)
+        eval_sum(bp, b, bn, m, 4, three);
+    mul_rec(v3, ap, m + 1, bp, m + 1, next);
+
+    ui *c0 = r, *c6 = r + 6 * m;
+    mul_rec(c0, a, m, b, m, next);
+    mul_rec(c6, a + 3 * m, an - 3 * m, b + 3 * m, bn - 3 * m, next);
+    std::fill(r + 2 * m, r + 6 * m, 0);
+
+    sub_n(v1, v1, vm1, w);              // 2 (c1 + c3 + c5)
+    rshift(v1, v1, w, 1);
+    add_n(vm1, vm1, v1, w);             // c0 + c2 + c4 + c6
+    sub(vm1, vm1, w, c0, 2 * m);
+    sub(vm1, vm1, w, c6, ct);           // c2 + c4
+
+    sub_n(v2, v2, vm2, w);              // 4 (c1 + 4 c3 + 16 c5)
+    rshift(v2, v2, w, 2);
+    addmul_1(vm2, v2, w, 2);            // c0 + 4 c2 + 16 c4 + 64 c6
+    sub(vm2, vm2, w, c0, 2 * m);
+    submul_wrap(vm2, w, c6, ct, 64);    // 4 (c2 + 4 c4)
+    rshift(vm2, vm2, w, 2);
+    sub_n(vm2, vm2, vm1, w);            // 3 c4
+    divexact_1(vm2, vm2, w, 3);
+    sub_n(vm1, vm1, vm2, w);            // c2
+
+    sub(v3, v3, w, c0, 2 * m);
+    submul_1(v3, vm1, w, 9);
+    submul_1(v3, vm2, w, 81);
+    submul_wrap(v3, w, c6, ct, 729);    // 3 (c1 + 9 c3 + 81 c5)
+    divexact_1(v3, v3, w, 3);
+    sub_n(v3, v3, v2, w);               // 5 (c3 + 13 c5)
+    divexact_1(v3, v3, w, 5);
+    sub_n(v2, v2, v1, w);               // 3 (c3 + 5 c5)
+    divexact_1(v2, v2, w, 3);
+    sub_n(v3, v3, v2, w);               // 8 c5
+    rshift(v3, v3, w, 3);
+    submul_1(v2, v3, w, 5);             // c3
+    sub_n(v1, v1, v2, w);
+    sub_n(v1, v1, v3, w);               // c1
+
+    ui *coeffs[] = {v1, vm1, v2, vm2, v3};
+    toom_add_coeffs(r, an + bn, m, w, coeffs, 5);
+}
+
+// NTT: the limbs are convolved modulo three primes below 2^31 that have large
+// power-of-two roots of unity, and the coefficients are recombined by CRT. A product
+// coefficient is below min(an, bn) * B^2 < p1 p2 p3 for all sizes up to NTT_MAX_SIZE.
+
+struct ntt_prime {
+    ui p;
+    ui g;   // primitive root modulo p
+};
+
+static ntt_prime const NTT_PRIMES[] = {{2013265921, 31}, {469762049, 3}, {754974721, 11}};
+
+static ui pow_mod(ull a, ull e, ui p) {
+    ull r = 1;
+    for (a %= p; e != 0; e >>= 1) {
+        if (e & 1)
+            r = r * a % p;
+        a = a * a % p;
+    }
+    return static_cast<ui>(r);
+}
+
+// Montgomery arithmetic modulo p < 2^31 with R = 2^32
+struct montgomery {
+    ui p;
+    ui pinv;    // -p^-1 mod R
+
+    explicit montgomery(ui p) : p(p), pinv(0 - binvert_limb(p)) {}
+
+    ui to_mont(ui a) const {
+        return static_cast<ui>(((ull) a << SHIFT) % p);
+    }
+
+    // a * b / R mod p
+    ui mul(ui a, ui b) const {
+        ull t = (ull) a * b;
+        ui m = static_cast<ui>(t) * pinv;
+        ui r = static_cast<ui>((t + (ull) m * p) >> SHIFT);
+        return r >= p ? r - p : r;
+    }
+
+    ui add(ui a, ui b) const {
+        ui r = a + b;
+        return r >= p ? r - p : r;
+    }
+
+    ui sub(ui a, ui b) const {
+        return a >= b ? a - b : a + p - b;
+    }
+};
+
+// rt[half + j] = w^j * R for the root w of order 2 half, for every power of two half < n
+static void ntt_roots(ui *rt, size_t n, ui root, montgomery const &mg) {
+    for (size_t half = n / 2; half >= 1; half /= 2) {
+        ull w = root;
+        ull x = 1;
+        for (size_t j = 0; j < half; j++) {
+            rt[half + j] = mg.to_mont(static_cast<ui>(x));
+            x = x * w % mg.p;
+        }
+        root = static_cast<ui>((ull) root * root % mg.p);
+    }
+}
+
+// decimation in frequency: natural order in, bit-reversed order out
+static void ntt_forward(ui *a, size_t n, ui const *rt, montgomery const &mg) {
+    for (size_t half = n / 2; half >= 1; half /= 2) {
+        for (size_t i = 0; i < n; i += 2 * half) {
+            for (size_t j = 0; j < half; j++) {
+                ui u = a[i + j];
+                ui v = a[i + j + half];
+                a[i + j] = mg.add(u, v);
+                a[i + j + half] = mg.mul(mg.sub(u, v), rt[half + j]);
+            }
+        }
+    }
+}
+
+// decimation in time with inverse roots: bit-reversed order in, natural order out
+static void ntt_inverse(ui *a, size_t n, ui const *irt, montgomery const &mg) {
+    for (size_t half = 1; half < n; half *= 2) {
+        for (size_t i = 0; i < n; i += 2 * half) {
+            for (size_t j = 0; j < half; j++) {
+                ui u = a[i + j];
+                ui v = mg.mul(a[i + j + half], irt[half + j]);
+                a[i + j] = mg.add(u, v);
+                a[i + j + half] = mg.sub(u, v);
+            }
+        }
+    }
+}
+
+static void ntt_load(ui *f, size_t n, ui const *a, size_t an, ui p) {
+    for (size_t i = 0; i < an; i++)
+        f[i] = a[i] % p;
+    std::fill(f + an, f + n, 0);
+}
+
+// r[0..rn) = sum of x_i B^i for x_i = v1 + p1 v2 + p1 p2 v3 given by its residues
+static void ntt_crt(ui *r, size_t rn, ui const *f1, ui const *f2, ui const *f3, size_t n) {
+    ui p1 = NTT_PRIMES[0].p, p2 = NTT_PRIMES[1].p, p3 = NTT_PRIMES[2].p;
+    ull inv1 = pow_mod(p1, p2 - 2, p2);
+    ull inv12 = pow_mod((ull) p1 * p2 % p3, p3 - 2, p3);
+    ull p12 = (ull) p1 * p2;
+
+    ull carry = 0;
+    for (size_t i = 0; i < rn; i++) {
+        ull xl = 0, xh = 0;
+        if (i < n) {
+            ull v1 = f1[i];
+            ull v2 = (f2[i] + p2 - v1 % p2) * inv1 % p2;
+            ull t = (f3[i] + p3 - v1 % p3) % p3;
+            t = (t + p3 - p1 % p3 * v2 % p3) % p3;
+            ull v3 = t * inv12 % p3;
+
+            ull low = v1 + p1 * v2;
+            ull mid = (p12 & UINT32_MAX) * v3;
+            ull sum = (low & UINT32_MAX) + (mid & UINT32_MAX);
+            xl = sum & UINT32_MAX;
+            xh = (low >> SHIFT) + (mid >> SHIFT) + (p12 >> SHIFT) * v3 + (sum >> SHIFT);
+        }
+        ull t = xl + (carry & UINT32_MAX);
+        r[i] = static_cast<ui>(t);
+        carry = xh + (carry >> SHIFT) + (t >> SHIFT);
+    }
+}
+
+// requires an + bn <= NTT_MAX_SIZE
+static void mul_ntt(ui *r, ui const *a, size_t an, ui const *b, size_t bn) {
+    size_t rn = an + bn;
+    size_t n = 1;
+    while (n < rn - 1)
+        n <<= 1;
+
+    std::vector<ui> res(3 * n);
+    std::vector<ui> tmp(is_square(a, an, b, bn) ? 0 : n), rt(n), irt(n);
+    for (size_t k = 0; k < 3; k++) {
+        ui p = NTT_PRIMES[k].p;
+        montgomery mg(p);
+        ui root = pow_mod(NTT_PRIMES[k].g, (p - 1) / n, p);
+        ntt_roots(rt.data(), n, root, mg);
+        ntt_roots(irt.data(), n, pow_mod(root, p - 2, p), mg);
+
+        ui *f = res.data() + k * n;
+        ntt_load(f, n, a, an, p);
+        ntt_forward(f, n, rt.data(), mg);
+        ui const *g = f;
+        if (!is_square(a, an, b, bn)) {
+            ntt_load(tmp.data(), n, b, bn, p);
+            ntt_forward(tmp.data(), n, rt.data(), mg);
+            g = tmp.data();
+        }
+        for (size_t i = 0; i < n; i++)
+            f[i] = mg.mul(f[i], g[i]);
+        ntt_inverse(f, n, irt.data(), mg);
+
+        // the pointwise products lost a factor R, the inverse transform gained n
+        ui scale = static_cast<ui>((ull) mg.to_mont(mg.to_mont(1)) * pow_mod(n, p - 2, p) % p);
+        for (size_t i = 0; i < n; i++)
+            f[i] = mg.mul(f[i], scale);
+    }
+    ntt_crt(r, rn, res.data(), res.data() + n, res.data() + 2 * n, std::min(n, rn - 1));
+}
+
+static void mul_rec(ui *r, ui const *a, size_t an, ui const *b, size_t bn, ui *ws) {
+    if (an < bn) {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+
+    if (is_square(a, an, b, bn) && an < sqr_karatsuba_threshold())
+        sqr_basecase(r, a, an);
+    else if (bn < KARATSUBA_THRESHOLD)
+        mul_basecase(r, a, an, b, bn);
+    else if (an >= UNBALANCED_RATIO * bn || bn <= (an + 1) / 2)
+        mul_unbalanced(r, a, an, b, bn, ws);
+    else if (bn >= NTT_THRESHOLD && an + bn <= NTT_MAX_SIZE)
+        mul_ntt(r, a, an, b, bn);
+    else if (bn >= TOOM4_THRESHOLD && bn > 3 * ((an + 3) / 4))
+        toom4(r, a, an, b, bn, ws);
+    else if (bn >= TOOM3_THRESHOLD && bn > 2 * ((an + 2) / 3))
+        toom3(r, a, an, b, bn, ws);
+    else
+        karatsuba(r, a, an, b, bn, ws);
+}
+
+void mul(ui *r, ui const *a, size_t an, ui const *b, size_t bn) {
+    if (an < bn) {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+
+    // neither basecase needs scratch
+    if (is_square(a, an, b, bn) && an < sqr_karatsuba_threshold()) {
+        sqr_basecase(r, a, an);
+        return;
+    }
+    if (bn < KARATSUBA_THRESHOLD) {
+        mul_basecase(r, a, an, b, bn);
+        return;
+    }
+
+    // chunks of an unbalanced product only need room for one chunk product
+    std::vector<ui> ws(2 * bn + mul_itch(std::min(an, UNBALANCED_RATIO * bn)));
+    mul_rec(r, a, an, b, bn, ws.data());
+}
+
+void sqr(ui *r, ui const *a, size_t n) {
+    mul(r, a, n, a, n);
+}
+
+static void mullo_basecase(ui *r, ui const *a, size_t an, ui const *b, size_t bn, size_t n) {
+    std::fill(r, r + n, 0);
+    for (size_t j = 0; j < bn && j < n; j++) {
+        size_t len = std::min(an, n - j);
+        ui carry = addmul_1(r + j, a, len, b[j]);
+        if (j + len < n)
+            r[j + len] = carry;
+    }
+}
+
+static size_t mullo_itch(size_t n) {
+    if (n < MULLO_THRESHOLD)
+        return 0;
+    size_t h = n - n * 3 / 10;
+    return 2 * h + (n - h) + mullo_itch(n - h);
+}
+
+// Mulders' short product: the low block a0 * b0 (0.7 n limbs each) is a full product,
+// the cross terms a1 * b0 and a0 * b1 are short products of the remaining 0.3 n limbs
+// and a1 * b1 lies entirely above B^n
+static void mullo_rec(ui *r, ui const *a, size_t an, ui const *b, size_t bn, size_t n, ui *ws) {
+    if (an + bn <= n) {
+        mul(r, a, an, b, bn);
+        std::fill(r + an + bn, r + n, 0);
+        return;
+    }
+    if (std::min(an, bn) < MULLO_THRESHOLD) {
+        mullo_basecase(r, a, an, b, bn, n);
+        return;
+    }
+
+    size_t h = n - n * 3 / 10;
+    size_t l = n - h;
+    size_t a0n = std::min(an, h);
+    size_t b0n = std::min(bn, h);
+    mul(ws, a, a0n, b, b0n);
+    std::copy(ws, ws + std::min(n, a0n + b0n), r);
+    if (a0n + b0n < n)
+        std::fill(r + a0n + b0n, r + n, 0);
+
+    ui *cross = ws + 2 * h;
+    if (an > h) {
+        mullo_rec(cross, a + h, std::min(an - h, l), b, std::min(bn, l), l, cross + l);
+        add_n(r + h, r + h, cross, l);
+    }
+    if (bn > h) {
+        mullo_rec(cross, a, std::min(an, l), b + h, std::min(bn - h, l), l, cross + l);
+        add_n(r + h, r + h, cross, l);
+    }
+}
+
+void mullo(ui *r, ui const *a, size_t an, ui const *b, size_t bn, size_t n) {
+    an = std::min(an, n);
+    bn = std::min(bn, n);
+    std::vector<ui> ws(mullo_itch(n));
+    mullo_rec(r, a, an, b, bn, n, ws.data());
+}
+
+// r += a * b, leaving out the limb products a_i b_j with i + j < k; r has rn >= an + bn limbs.
+// Every product left out is one of those below column k of the top-level call, so together
+// they stay below 2k B^(k + 1)
+static void mulhi_rec(ui *r, size_t rn, ui const *a, size_t an, ui const *b, size_t bn, ptrdiff_t k, ui *ws) {
+    if (static_cast<ptrdiff_t>(an + bn) <= k + 1)
+        return;
+    if (k <= 0) {
+        mul(ws, a, an, b, bn);
+        add(r, r, rn, ws, an + bn);
+        return;
+    }
+    if (std::min(an, bn) < MULHI_THRESHOLD) {
+        for (size_t j = 0; j < bn; j++) {
+            size_t i = k > static_cast<ptrdiff_t>(j) ? static_cast<size_t>(k) - j : 0;
+            if (i >= an)
+                continue;
+            ui carry = addmul_1(r + j + i, a + i, an - i, b[j]);
+            add_1(r + j + an, r + j + an, rn - j - an, carry);
+        }
+        return;
+    }
+
+    // as in Mulders' short product, the high blocks are multiplied in full
+    size_t h = std::min(an, bn) * 3 / 10;
+    ptrdiff_t sh = static_cast<ptrdiff_t>(h);
+    // k = 0: the high block is always computed as a full product
+    mulhi_rec(r + 2 * h, rn - 2 * h, a + h, an - h, b + h, bn - h, 0, ws);
+    mulhi_rec(r + h, rn - h, a + h, an - h, b, h, k - sh, ws);
+    mulhi_rec(r + h, rn - h, a, h, b + h, bn - h, k - sh, ws);
+    mulhi_rec(r, rn, a, h, b, h, k, ws);
+}
+
+void mulhi(ui *r, ui const *a, size_t an, ui const *b, size_t bn, size_t n) {
+    size_t rn = an + bn;
+    std::vector<ui> p(rn), ws(rn);
+    if (n >= 3 && std::min(an, bn) < MULHI_MUL_THRESHOLD) {
+        // the part left out is below B^(n - 1): unless limb n - 1 is all ones, it cannot carry into limb n
+        mulhi_rec(p.data(), rn, a, an, b, bn, static_cast<ptrdiff_t>(n - 3), ws.data());
+        if (p[n - 1] != UINT32_MAX) {
+            std::copy(p.begin() + n, p.end(), r);
+            return;
+        }
+        std::fill(p.begin(), p.end(), 0);
+    }
+    mul(p.data(), a, an, b, bn);
+    std::copy(p.begin() + n, p.end(), r);
+}
+
+// Hensel's division of w by odd d, qn limbs from the bottom: each row adds the multiple of d
+// that clears the lowest limb left, so the rows make up -w / d mod B^qn, written to q unless
+// it is null; addmul_1 is cheaper than submul_1. Only w[0, wn) is kept and the carry out of
+// the top limb of a row waits for the next row. With wn = qn + dn + 1 nothing is dropped:
+// w[qn, wn) is then the remainder (w + (-q) d) / B^qn
+static void bdiv_r_basecase(ui *q, ui *w, size_t wn, size_t qn, ui const *d, size_t dn) {
+    ui ninv = 0 - binvert_limb(d[0]);
+    ui cy = 0;
+    for (size_t i = 0; i < qn; i++) {
+        ui qi = w[i] * ninv;
+        if (q)
+            q[i] = qi;
+        if (i + dn < wn) {
+            ull top = (ull) addmul_1(w + i, d, dn, qi) + w[i + dn] + cy;
+            w[i + dn] = static_cast<ui>(top);
+            cy = static_cast<ui>(top >> SHIFT);
+        } else {
+            addmul_1(w + i, d, wn - i, qi);
+        }
+    }
+    if (qn + dn < wn)
+        w[qn + dn] += cy;
+}
+
+// q = w / d mod B^qn for odd d; w is destroyed
+static void bdiv_q_basecase(ui *q, ui *w, size_t qn, ui const *d, size_t dn) {
+    bdiv_r_basecase(q, w, qn, qn, d, dn);
+    neg_wrap(q, qn);
+}
+
+// q = w / d mod B^n from the low n limbs of w and d: the low half of the quotient first, then
+// the high half from what is left of w once the low half times d is taken off. Only the
+// limbs of w above the low half change there, as the low ones cancel exactly
+static void bdiv_q_dc(ui *q, ui *w, size_t n, ui const *d, ui *ws) {
+    if (n < BDIV_DC_THRESHOLD) {
+        bdiv_q_basecase(q, w, n, d, n);
+        return;
+    }
+    size_t lo = n / 2;
+    size_t hi = n - lo;
+    bdiv_q_dc(q, w, lo, d, ws);
+    mullo(ws, q, lo, d, n, n);
+    sub_n(w + lo, w + lo, ws + lo, hi);
+    bdiv_q_dc(q + lo, w + lo, hi, d, ws);
+}
+
+// blocks of k = min(qn, dn) quotient limbs; the product of a block with d is taken off the
+// limbs of w above the block before the next one, the ones below cancel as above
+static void bdiv_q(ui *q, ui *w, size_t qn, ui const *d, size_t dn) {
+    size_t k = std::min(qn, dn);
+    std::vector<ui> ws(k), p(k + dn);
+    for (size_t off = 0; off < qn; off += k) {
+        size_t len = std::min(k, qn - off);
+        bdiv_q_dc(q + off, w + off, len, d, ws.data());
+        size_t rest = qn - off;
+        if (len < rest) {
+            size_t pdn = std::min(dn, rest);
+            mul(p.data(), d, pdn, q + off, len);
+            sub(w + off + len, w + off + len, rest - len, p.data() + len, std::min(len + pdn, rest) - len);
+        }
+    }
+}
+
+// w[qn, qn + dn + 1) = (w + (-q) d) / B^qn with -q = -w / d mod B^qn for odd d, where w has
+// qn + dn + 1 limbs and the top two are 0. The quotient is taken off a block of k = min(qn, dn)
+// limbs at a time and never kept whole; the remainder is below 2d
+static void bdiv_r(ui *w, size_t qn, ui const *d, size_t dn) {
+    size_t wn = qn + dn + 1;
+    size_t k = std::min(qn, dn);
+    if (k < BDIV_DC_THRESHOLD) {
+        bdiv_r_basecase(nullptr, w, wn, qn, d, dn);
+        return;
+    }
+    std::vector<ui> q(k), ws(k), p(k + dn);
+    for (size_t off = 0; off < qn; off += k) {
+        size_t len = std::min(k, qn - off);
+        // bdiv_q_dc destroys its copy of the block, which the addition below still needs
+        std::copy(w + off, w + off + len, p.begin());
+        bdiv_q_dc(q.data(), p.data(), len, d, ws.data());
+        neg_wrap(q.data(), len);
+        mul(p.data(), d, dn, q.data(), len);
+        add(w + off, w + off, wn - off, p.data(), dn + len);
+    }
+}
+
+void divexact(ui *q, ui const *a, size_t an, ui const *d, size_t dn) {
+    size_t qn = an - dn + 1;
+    // zero limbs at the bottom of d are zero in a as well
+    while (d[0] == 0) {
+        a++;
+        an--;
+        d++;
+        dn--;
+    }
+    size_t wn = std::min(an, qn + 1);
+    std::vector<ui> w(a, a + wn), dv(d, d + dn);
+    unsigned shift = 0;
+    while (!(d[0] >> shift & 1))
+        shift++;
+    if (shift) {
+        rshift(w.data(), w.data(), wn, shift);
+        rshift(dv.data(), dv.data(), dn, shift);
+        if (dv[dn - 1] == 0)
+            dn--;
+    }
+    std::fill(q + std::min(qn, wn), q + qn, 0);
+    qn = std::min(qn, wn);
+
+    if (dn == 1)
+        divexact_1(q, w.data(), qn, dv[0]);
+    else if (std::min(qn, dn) < BDIV_DC_THRESHOLD)
+        bdiv_q_basecase(q, w.data(), qn, dv.data(), dn);
+    else
+        bdiv_q(q, w.data(), qn, dv.data(), std::min(qn, dn));
+}
+
+ui modexact_1(ui const *a, size_t n, ui d) {
+    ui inv = binvert_limb(d);
+    ui c = 0;
+    for (size_t i = 0; i < n; i++) {
+        ull diff = (ull) a[i] - c;
+        ui q = static_cast<ui>(diff) * inv;
+        c = static_cast<ui>(((ull) q * d) >> SHIFT) + static_cast<ui>(diff >> 63);
+    }
+    return c;
+}
+
+bool divisible(ui const *a, size_t an, ui const *d, size_t dn) {
+    // the power of two in d has to divide a, the odd part of d divides a or not whatever
+    // power of two a is divided by
+    for (; d[0] == 0; d++, dn--, a++, an--) {
+        if (an == 0)
+            return true;
+        if (a[0] != 0)
+            return false;
+    }
+    unsigned twos = 0;
+    while (!(d[0] >> twos & 1))
+        twos++;
+    if (an == 0)
+        return true;
+    if (a[0] & ((1u << twos) - 1))
+        return false;
+    while (an > 0 && a[an - 1] == 0)
+        an--;
+    if (an == 0)
+        return true;
+
+    std::vector<ui> dv(d, d + dn);
+    if (twos) {
+        rshift(dv.data(), dv.data(), dn, twos);
+        if (dv[dn - 1] == 0)
+            dn--;
+    }
+    if (dn == 1) {
+        ui c = modexact_1(a, an, dv[0]);
+        return c == 0 || c == dv[0];
+    }
+    if (an < dn)
+        return false;
+
+    // B^qn is invertible modulo the odd d, so d divides a exactly when it divides the Hensel
+    // remainder, which is below 2d: it is 0 or d then
+    size_t qn = an - dn + 1;
+    std::vector<ui> w(an + 2, 0);
+    std::copy(a, a + an, w.begin());
+    bdiv_r(w.data(), qn, dv.data(), dn);
+    ui const *r = &w[qn];
+    return r[dn] == 0 && (std::all_of(r, r + dn, [](ui x) { return x == 0; }) || cmp(r, dv.data(), dn) == 0);
+}
+
+}
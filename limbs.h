@@ -0,0 +1,113 @@
+#ifndef BIGINT_LIMBS_H
+#define BIGINT_LIMBS_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Low-level arithmetic on little-endian arrays of 32-bit limbs.
+// Unless stated otherwise, output arrays must not overlap the inputs.
+namespace limbs {
+    typedef uint32_t ui;
+    typedef uint64_t ull;
+
+    // operand sizes (in limbs of the shorter operand) from which operator*= switches
+    // from schoolbook to Karatsuba, then to Toom-3, Toom-4 and the NTT
+    size_t const KARATSUBA_THRESHOLD = 48;
+    // squares stay on their own schoolbook loop longer, as it needs half the limb products;
+    // with vector kernels they switch at KARATSUBA_THRESHOLD like other products
+    size_t const SQR_KARATSUBA_THRESHOLD = 96;
+    size_t const TOOM3_THRESHOLD = 150;
+    size_t const TOOM4_THRESHOLD = 400;
+    size_t const NTT_THRESHOLD = 40000;
+    // longest product (an + bn limbs) the NTT can compute; larger ones are split by Toom-4
+    size_t const NTT_MAX_SIZE = (size_t) 1 << 24;
+    // from this ratio of operand sizes on, the longer operand is multiplied chunk by chunk
+    size_t const UNBALANCED_RATIO = 2;
+    // division switches from schoolbook to divide and conquer when divisor and quotient
+    // both have this many limbs
+    size_t const DC_DIV_THRESHOLD = 40;
+    // short products split into smaller full and short products from these sizes on;
+    // from MULHI_MUL_THRESHOLD on the high half is cheaper to take from the full product
+    size_t const MULLO_THRESHOLD = 100;
+    size_t const MULHI_THRESHOLD = 100;
+    size_t const MULHI_MUL_THRESHOLD = 300;
+    // exact division switches from one quotient limb at a time to divide and conquer
+    // when quotient and divisor both have this many limbs
+    size_t const BDIV_DC_THRESHOLD = 400;
+
+    // add_n, sub_n and mul_basecase have AVX2 and AVX-512 versions, picked at startup from what
+    // the CPU supports. The vector basecase takes over for bn in [SIMD_MUL_MIN_BN, SIMD_MUL_MAX_BN]
+    size_t const SIMD_MUL_MIN_BN = 12;
+    size_t const SIMD_MUL_MAX_BN = 64;
+
+    enum class isa { scalar, avx2, avx512 };
+    // the best instruction set of this CPU; set_isa switches the kernels to the requested one
+    // or, if the CPU lacks it, to the best one below, and returns what it chose. set_isa is
+    // meant for tests and benchmarks: it rewrites the kernel table without synchronisation,
+    // so it must not run while another thread does arithmetic
+    isa best_isa();
+    isa set_isa(isa requested);
+
+    // r = a + b, returns carry; r may coincide with a or b
+    ui add_n(ui *r, ui const *a, ui const *b, size_t n);
+    // r = a - b, returns borrow; r may coincide with a or b
+    ui sub_n(ui *r, ui const *a, ui const *b, size_t n);
+    // same for an >= bn, r has an limbs
+    ui add(ui *r, ui const *a, size_t an, ui const *b, size_t bn);
+    ui sub(ui *r, ui const *a, size_t an, ui const *b, size_t bn);
+    // r = a +- b for a single limb b; r may coincide with a
+    ui add_1(ui *r, ui const *a, size_t n, ui b);
+    ui sub_1(ui *r, ui const *a, size_t n, ui b);
+    // -1, 0 or 1 as a is less than, equal to or greater than b
+    int cmp(ui const *a, ui const *b, size_t n);
+
+    // r = a * b, r += a * b, r -= a * b; return the limb carried out
+    ui mul_1(ui *r, ui const *a, size_t n, ui b);
+    ui addmul_1(ui *r, ui const *a, size_t n, ui b);
+    ui submul_1(ui *r, ui const *a, size_t n, ui b);
+
+    // r = a << cnt and r = a >> cnt for 0 < cnt < 32, return the bits shifted out
+    // (in the low end of the limb for lshift, in the high end for rshift); r may coincide with a
+    ui lshift(ui *r, ui const *a, size_t n, unsigned cnt);
+    ui rshift(ui *r, ui const *a, size_t n, unsigned cnt);
+    // q = a / d, returns a % d; q may coincide with a
+    ui divrem_1(ui *q, ui const *a, size_t n, ui d);
+    // the same for d shifted left by shift to have the top bit set and dinv = invert_limb(d)
+    ui divrem_1(ui *q, ui const *a, size_t n, ui d, unsigned shift, ui dinv);
+    ui mod_1(ui const *a, size_t n, ui d);
+    // a / d for a divisor with the top bit set and dn >= 2, in place: q gets the low an - dn
+    // limbs of a / d and the top one is returned, a keeps a % d in its low dn limbs and zeros
+    // above. Knuth's algorithm D, recursive (Burnikel-Ziegler) for large operands
+    ui div_qr(ui *q, ui *a, size_t an, ui const *d, size_t dn);
+    // the same with dinv = invert_3by2(d[dn - 1], d[dn - 2]) computed beforehand
+    ui div_qr(ui *q, ui *a, size_t an, ui const *d, size_t dn, ui dinv);
+    // reciprocals for d1 with the top bit set: floor((B^2 - 1) / d1) - B and
+    // floor((B^3 - 1) / (d1 B + d0)) - B. They turn the quotient estimates of division
+    // into multiplications
+    ui invert_limb(ui d1);
+    ui invert_3by2(ui d1, ui d0);
+    // r = a / d for odd d, when a is known to be a multiple of d
+    void divexact_1(ui *r, ui const *a, size_t n, ui d);
+    // for odd d, 0 or d when d divides a and something else otherwise: divexact_1 without
+    // the quotient
+    ui modexact_1(ui const *a, size_t n, ui d);
+    // whether d divides a, for d with a non-zero top limb
+    bool divisible(ui const *a, size_t an, ui const *d, size_t dn);
+    // q = a / d for any d when a is known to be a multiple of it; q has an - dn + 1 limbs.
+    // Hensel's division from the low end: no quotient limb ever needs correcting, and only
+    // the low an - dn + 1 limbs of d come into it. For large operands of similar size div_qr
+    // is faster
+    void divexact(ui *q, ui const *a, size_t an, ui const *d, size_t dn);
+
+    // r = a * b, r has an + bn limbs; mul squares when a and b are the same operand
+    void mul_basecase(ui *r, ui const *a, size_t an, ui const *b, size_t bn);
+    void mul(ui *r, ui const *a, size_t an, ui const *b, size_t bn);
+    // r = a * a, r has 2n limbs
+    void sqr_basecase(ui *r, ui const *a, size_t n);
+    void sqr(ui *r, ui const *a, size_t n);
+    // short products: r = a * b mod B^n (r has n limbs) and r = a * b / B^n (r has an + bn - n limbs, n < an + bn)
+    void mullo(ui *r, ui const *a, size_t an, ui const *b, size_t bn, size_t n);
+    void mulhi(ui *r, ui const *a, size_t an, ui const *b, size_t bn, size_t n);
+}
+
+#endif //BIGINT_LIMBS_H
@@ -0,0 +1,223 @@
+#include "limbs_x86.h"
+
+#if BIGINT_X86_KERNELS
+#include <immintrin.h>
+#include <algorithm>
+
+namespace limbs {
+namespace x86 {
+
+ui const SHIFT = 32;
+// limbs of a whose products with b are summed up in one pass of the basecase
+size_t const MUL_BLOCK = 64;
+
+bool has_avx2() {
+    return __builtin_cpu_supports("avx2");
+}
+
+bool has_avx512() {
+    return __builtin_cpu_supports("avx512f");
+}
+
+// Carries between lanes: g has the lanes whose sum wrapped around, p the lanes that pass
+// an incoming carry on (sum all ones). Adding (g << 1) + p + carry as plain integers runs
+// the carries through the lanes at once: a bit of the result differs from p exactly where
+// a carry comes in, and the bit above the top lane is the carry out.
+static inline unsigned lane_carries(unsigned g, unsigned p, ui &carry, unsigned lanes) {
+    unsigned c = (g << 1) + p + carry;
+    carry = c >> lanes;
+    return (c ^ p) & ((1u << lanes) - 1);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mask_to_lanes(unsigned mask) {
+    __m256i const bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)), bits), bits);
+}
+
+__attribute__((target("avx2")))
+static inline unsigned lanes_to_mask(__m256i v) {
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(v)));
+}
+
+__attribute__((target("avx2")))
+ui add_n_avx2(ui *r, ui const *a, ui const *b, size_t n) {
+    __m256i const ones = _mm256_set1_epi32(-1);
+    ui carry = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + i));
+        __m256i s = _mm256_add_epi32(x, y);
+        // s < x unsigned where the sum wrapped around
+        unsigned g = ~lanes_to_mask(_mm256_cmpeq_epi32(_mm256_max_epu32(s, x), s)) & 0xff;
+        unsigned p = lanes_to_mask(_mm256_cmpeq_epi32(s, ones));
+        unsigned c = lane_carries(g, p, carry, 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), _mm256_sub_epi32(s, mask_to_lanes(c)));
+    }
+    for (; i < n; i++) {
+        ull sum = (ull) a[i] + b[i] + carry;
+        r[i] = static_cast<ui>(sum);
+        carry = static_cast<ui>(sum >> SHIFT);
+    }
+    return carry;
+}
+
+__attribute__((target("avx2")))
+ui sub_n_avx2(ui *r, ui const *a, ui const *b, size_t n) {
+    ui borrow = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + i));
+        __m256i d = _mm256_sub_epi32(x, y);
+        // x < y unsigned where the difference wrapped around, a zero difference passes a borrow on
+        unsigned g = ~lanes_to_mask(_mm256_cmpeq_epi32(_mm256_max_epu32(x, y), x)) & 0xff;
+        unsigned p = lanes_to_mask(_mm256_cmpeq_epi32(d, _mm256_setzero_si256()));
+        unsigned c = lane_carries(g, p, borrow, 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), _mm256_add_epi32(d, mask_to_lanes(c)));
+    }
+    for (; i < n; i++) {
+        ull diff = (ull) a[i] - b[i] - borrow;
+        r[i] = static_cast<ui>(diff);
+        borrow = static_cast<ui>(diff >> 63);
+    }
+    return borrow;
+}
+
+__attribute__((target("avx512f")))
+ui add_n_avx512(ui *r, ui const *a, ui const *b, size_t n) {
+    __m512i const ones = _mm512_set1_epi32(-1);
+    ui carry = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        __m512i s = _mm512_add_epi32(x, y);
+        unsigned g = _mm512_cmplt_epu32_mask(s, x);
+        unsigned p = _mm512_cmpeq_epi32_mask(s, ones);
+        __mmask16 c = static_cast<__mmask16>(lane_carries(g, p, carry, 16));
+        _mm512_storeu_si512(r + i, _mm512_mask_sub_epi32(s, c, s, ones));
+    }
+    for (; i < n; i++) {
+        ull sum = (ull) a[i] + b[i] + carry;
+        r[i] = static_cast<ui>(sum);
+        carry = static_cast<ui>(sum >> SHIFT);
+    }
+    return carry;
+}
+
+__attribute__((target("avx512f")))
+ui sub_n_avx512(ui *r, ui const *a, ui const *b, size_t n) {
+    __m512i const ones = _mm512_set1_epi32(-1);
+    ui borrow = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        __m512i d = _mm512_sub_epi32(x, y);
+        unsigned g = _mm512_cmplt_epu32_mask(x, y);
+        unsigned p = _mm512_cmpeq_epi32_mask(d, _mm512_setzero_si512());
+        __mmask16 c = static_cast<__mmask16>(lane_carries(g, p, borrow, 16));
+        _mm512_storeu_si512(r + i, _mm512_mask_add_epi32(d, c, d, ones));
+    }
+    for (; i < n; i++) {
+        ull diff = (ull) a[i] - b[i] - borrow;
+        r[i] = static_cast<ui>(diff);
+        borrow = static_cast<ui>(diff >> 63);
+    }
+    return borrow;
+}
+
+// r[0, cols) = lo + hi one column up + r[0, keep): the column sums of a block turned into limbs,
+// on top of the limbs the previous block left in the first columns
+static void merge_block(ui *r, ull const *lo, ull const *hi, size_t cols, size_t keep) {
+    ull carry = 0;
+    for (size_t c = 0; c < cols; c++) {
+        carry += lo[c] + (c ? hi[c - 1] : 0) + (c < keep ? r[c] : 0);
+        r[c] = static_cast<ui>(carry);
+        carry >>= SHIFT;
+    }
+}
+
+// The 64-bit products are split into their halves, summed column by column into separate
+// 64-bit lanes, so nothing carries between limbs until merge_block: each lane takes fewer
+// than 2^32 halves of at most 32 bits.
+__attribute__((target("avx2")))
+void mul_basecase_avx2(ui *r, ui const *a, size_t an, ui const *b, size_t bn) {
+    alignas(32) ull lo[MUL_BLOCK + SIMD_MUL_MAX_BN + 4];
+    alignas(32) ull hi[MUL_BLOCK + SIMD_MUL_MAX_BN + 4];
+    __m256i const low_half = _mm256_set1_epi64x(0xffffffff);
+
+    for (size_t off = 0; off < an; off += MUL_BLOCK) {
+        size_t len = std::min(MUL_BLOCK, an - off);
+        ui const *ab = a + off;
+        std::fill(lo, lo + len + bn, 0);
+        std::fill(hi, hi + len + bn, 0);
+
+        for (size_t j = 0; j < bn; j++) {
+            __m256i bj = _mm256_set1_epi64x(b[j]);
+            size_t i = 0;
+            for (; i + 4 <= len; i += 4) {
+                __m256i av = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const *>(ab + i)));
+                __m256i p = _mm256_mul_epu32(av, bj);
+                __m256i *pl = reinterpret_cast<__m256i *>(lo + i + j);
+                __m256i *ph = reinterpret_cast<__m256i *>(hi + i + j);
+                _mm256_storeu_si256(pl, _mm256_add_epi64(_mm256_loadu_si256(pl), _mm256_and_si256(p, low_half)));
+                _mm256_storeu_si256(ph, _mm256_add_epi64(_mm256_loadu_si256(ph), _mm256_srli_epi64(p, 32)));
+            }
+            for (; i < len; i++) {
+                ull p = (ull) ab[i] * b[j];
+                lo[i + j] += static_cast<ui>(p);
+                hi[i + j] += p >> SHIFT;
+            }
+        }
+        merge_block(r + off, lo, hi, len + bn, off ? bn : 0);
+    }
+}
+
+// GCC 12 warns about the placeholder operands inside its own AVX-512 intrinsics
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+__attribute__((target("avx512f")))
+void mul_basecase_avx512(ui *r, ui const *a, size_t an, ui const *b, size_t bn) {
+    alignas(64) ull lo[MUL_BLOCK + SIMD_MUL_MAX_BN + 8];
+    alignas(64) ull hi[MUL_BLOCK + SIMD_MUL_MAX_BN + 8];
+    __m512i const low_half = _mm512_set1_epi64(0xffffffff);
+
+    for (size_t off = 0; off < an; off += MUL_BLOCK) {
+        size_t len = std::min(MUL_BLOCK, an - off);
+        ui const *ab = a + off;
+        std::fill(lo, lo + len + bn, 0);
+        std::fill(hi, hi + len + bn, 0);
+
+        for (size_t j = 0; j < bn; j++) {
+            __m512i bj = _mm512_set1_epi64(b[j]);
+            size_t i = 0;
+            for (; i + 8 <= len; i += 8) {
+                __m512i av = _mm512_cvtepu32_epi64(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(ab + i)));
+                __m512i p = _mm512_mul_epu32(av, bj);
+                ull *pl = lo + i + j;
+                ull *ph = hi + i + j;
+                _mm512_storeu_si512(pl, _mm512_add_epi64(_mm512_loadu_si512(pl), _mm512_and_si512(p, low_half)));
+                _mm512_storeu_si512(ph, _mm512_add_epi64(_mm512_loadu_si512(ph), _mm512_srli_epi64(p, 32)));
+            }
+            for (; i < len; i++) {
+                ull p = (ull) ab[i] * b[j];
+                lo[i + j] += static_cast<ui>(p);
+                hi[i + j] += p >> SHIFT;
+            }
+        }
+        merge_block(r + off, lo, hi, len + bn, off ? bn : 0);
+    }
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+}
+}
+
+#endif
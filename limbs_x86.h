@@ -0,0 +1,30 @@
+#ifndef BIGINT_LIMBS_X86_H
+#define BIGINT_LIMBS_X86_H
+
+#include "limbs.h"
+
+// AVX2 and AVX-512 versions of the hot limb kernels. They are compiled for their
+// instruction set whatever the flags of the build, limbs.cpp picks them at runtime.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BIGINT_X86_KERNELS 1
+
+namespace limbs {
+namespace x86 {
+    bool has_avx2();
+    bool has_avx512();
+
+    ui add_n_avx2(ui *r, ui const *a, ui const *b, size_t n);
+    ui sub_n_avx2(ui *r, ui const *a, ui const *b, size_t n);
+    void mul_basecase_avx2(ui *r, ui const *a, size_t an, ui const *b, size_t bn);
+
+    ui add_n_avx512(ui *r, ui const *a, ui const *b, size_t n);
+    ui sub_n_avx512(ui *r, ui const *a, ui const *b, size_t n);
+    void mul_basecase_avx512(ui *r, ui const *a, size_t an, ui const *b, size_t bn);
+}
+}
+
+#else
+#define BIGINT_X86_KERNELS 0
+#endif
+
+#endif //BIGINT_LIMBS_X86_H
@@ -79,7 +79,7 @@ void my_vector::pop_back() {
 
 void my_vector::assign(size_t size, uint32_t element) {
     my_vector that(size, element);
-    std::swap(*this, that);
+    swap(that);
 }
 
 void my_vector::resize(size_t size, uint32_t element) {
@@ -96,6 +96,20 @@ void my_vector::resize(size_t size, uint32_t element) {
     size_ = size;
 }
 
+void my_vector::swap(my_vector &other) {
+    std::swap(is_small_, other.is_small_);
+    std::swap(size_, other.size_);
+    std::swap(data_.small, other.data_.small);
+    data_.big.swap(other.data_.big);
+}
+
+uint32_t *my_vector::data() {
+    return is_small_ ? data_.small : data_.big->data();
+}
+
+uint32_t const *my_vector::data() const {
+    return is_small_ ? data_.small : data_.big->data();
+}
 
 uint32_t &my_vector::operator[](size_t index) {
     if (is_small_) {
@@ -21,6 +21,10 @@ struct my_vector {
     void pop_back();
     void assign(size_t size, uint32_t element);
     void resize(size_t size, uint32_t element);
+    void swap(my_vector &other);
+
+    uint32_t* data();
+    uint32_t const* data() const;
 
     uint32_t& operator[](size_t index);
     uint32_t const& operator[](size_t index) const;
@@ -29,13 +33,13 @@ private:
     static const size_t SMALL_SIZE = 3;
     bool is_small_;
     size_t size_;
-    struct data {
+    struct storage {
         std::shared_ptr<std::vector <uint32_t>> big;
         uint32_t small[SMALL_SIZE] = {0};
-        data() : big(nullptr) {}
-        ~data() {big = nullptr;}
+        storage() : big(nullptr) {}
+        ~storage() {big = nullptr;}
     };
-    data data_;
+    storage data_;
     void to_big();
 };
 